@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include <functional>
 #include <memory>
+#include <type_traits>
 
 template <class, size_t MaxSize = 1024> class Function;
 
@@ -37,7 +38,7 @@ public:
 
   Function(const Function &other) {
     if (other) {
-      other.manager(data, other.data, Operation::Clone);
+      other.manager(&data, const_cast<Storage *>(&other.data), Operation::Clone);
       invoker = other.invoker;
       manager = other.manager;
     }
@@ -45,7 +46,9 @@ public:
 
   Function(Function &&other) { other.swap(*this); }
 
-  template <class F> Function(F &&f) {
+  template <class F, class = typename std::enable_if<!std::is_same<
+                         typename std::decay<F>::type, Function>::value>::type>
+  Function(F &&f) {
     using f_type = typename std::decay<F>::type;
     static_assert(alignof(f_type) <= alignof(Storage), "invalid alignment");
     static_assert(sizeof(f_type) <= sizeof(Storage), "storage too small");
@@ -79,7 +82,9 @@ public:
     return *this;
   }
 
-  template <typename F> Function &operator=(F &&f) {
+  template <typename F, class = typename std::enable_if<!std::is_same<
+                            typename std::decay<F>::type, Function>::value>::type>
+  Function &operator=(F &&f) {
     Function(std::forward<F>(f)).swap(*this);
     return *this;
   }
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/assign.dir/assign.cpp.o"
+  "CMakeFiles/assign.dir/assign.cpp.o.d"
+  "assign"
+  "assign.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/assign.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/commands.dir/commands.cpp.o"
+  "CMakeFiles/commands.dir/commands.cpp.o.d"
+  "commands"
+  "commands.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/commands.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/copies.dir/copies.cpp.o"
+  "CMakeFiles/copies.dir/copies.cpp.o.d"
+  "copies"
+  "copies.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/copies.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/events.dir/events.cpp.o"
+  "CMakeFiles/events.dir/events.cpp.o.d"
+  "events"
+  "events.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/events.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fork_join.dir/fork_join.cpp.o"
+  "CMakeFiles/fork_join.dir/fork_join.cpp.o.d"
+  "fork_join"
+  "fork_join.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fork_join.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
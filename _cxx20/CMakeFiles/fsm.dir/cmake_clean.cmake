@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fsm.dir/fsm.cpp.o"
+  "CMakeFiles/fsm.dir/fsm.cpp.o.d"
+  "fsm"
+  "fsm.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fsm.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/futures.dir/futures.cpp.o"
+  "CMakeFiles/futures.dir/futures.cpp.o.d"
+  "futures"
+  "futures.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/futures.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
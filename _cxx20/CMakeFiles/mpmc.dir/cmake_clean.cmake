@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mpmc.dir/mpmc.cpp.o"
+  "CMakeFiles/mpmc.dir/mpmc.cpp.o.d"
+  "mpmc"
+  "mpmc.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mpmc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/overload.dir/overload.cpp.o"
+  "CMakeFiles/overload.dir/overload.cpp.o.d"
+  "overload"
+  "overload.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/overload.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
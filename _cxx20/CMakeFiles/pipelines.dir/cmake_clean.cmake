@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/pipelines.dir/pipelines.cpp.o"
+  "CMakeFiles/pipelines.dir/pipelines.cpp.o.d"
+  "pipelines"
+  "pipelines.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pipelines.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/signals.dir/signals.cpp.o"
+  "CMakeFiles/signals.dir/signals.cpp.o.d"
+  "signals"
+  "signals.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/signals.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/swaps.dir/swaps.cpp.o"
+  "CMakeFiles/swaps.dir/swaps.cpp.o.d"
+  "swaps"
+  "swaps.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/swaps.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/timers.dir/timers.cpp.o"
+  "CMakeFiles/timers.dir/timers.cpp.o.d"
+  "timers"
+  "timers.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/timers.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/various.dir/various.cpp.o"
+  "CMakeFiles/various.dir/various.cpp.o.d"
+  "various"
+  "various.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/various.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include "workload.hpp"
+
+
+// Assignments made by each timed run.
+#define ASSIGNS 1000000
+
+typedef long handler(long);
+
+// Small enough for the small buffer of every implementation.
+template<int Tag>
+struct small
+{
+    long operator()(long x) const
+    {
+        return x * 3 + k + Tag;
+    }
+
+    long k;
+};
+
+// Too large for the small buffer of std::function and most others that
+// allocate, but still within the fixed capacity of those that cannot.
+template<int Tag>
+struct large
+{
+    long operator()(long x) const
+    {
+        return x * 3 + k[0] + k[3] + Tag;
+    }
+
+    long k[4];
+};
+
+// Assigns a and b in turn to the same wrapper, calling it after every
+// assignment.  With A and B the same type only the capture changes,
+// otherwise the wrapper changes the type it holds every time.  The results
+// are hashed rather than added, which the compiler could do in one go.
+template<class A, class B>
+struct assigning
+{
+    template<class F>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            A const a = {{1}};
+            B const b = {{2}};
+            F f(a);
+            long sum = 0;
+
+            auto const job = [&]
+            {
+                sum = 0;
+                for (long i = 0; i != ASSIGNS; i += 2)
+                {
+                    f = b;
+                    sum = sum * 31 + f(i);
+                    f = a;
+                    sum = sum * 31 + f(i + 1);
+                }
+            };
+
+            std::size_t const before = test::allocations();
+            job();
+            double const allocations = double(test::allocations() - before) / ASSIGNS;
+            double const elapsed = test::time_per_run(job);
+
+            test::live_code += static_cast<int>(sum);
+            test::report_rate(name, ASSIGNS / elapsed, "assigns");
+            std::cout << "{ns/assign: " << std::setprecision(2) << elapsed / ASSIGNS * 1e9
+                << ", allocations/assign: " << allocations
+                << ", checksum: " << std::hex << static_cast<std::uint64_t>(sum) << std::dec
+                << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<handler> >)
+        (Case< std::function<handler> >)
+        (Case< cxx_function::function<handler> >)
+        (Case< cxx_function::unique_function<handler> >)
+        (Case< multifunction<handler> >)
+        (Case< boost::function<handler> >)
+        (Case< func::function<handler> >)
+        (Case< generic::delegate<handler> >)
+        (Case< fu2::function<handler> >)
+        (Case< fu2::unique_function<handler> >)
+        (Case< fixed_size_function<handler> >)
+        (Case< gnr_forwarder<handler> >)
+        (Case< embxx_util_StaticFunction<handler> >)
+        (Case< Function_<handler> >)
+        (Case< SmallFun<handler> >)
+    )
+    std::cout << std::endl;
+}
+
+int main()
+{
+    benchmark<assigning<small<0>, small<0>>::with>("small, same type");
+    benchmark<assigning<small<0>, small<1>>::with>("small, other type");
+    benchmark<assigning<large<0>, large<0>>::with>("large, same type");
+    benchmark<assigning<large<0>, large<1>>::with>("large, other type");
+    benchmark<assigning<small<0>, large<1>>::with>("small and large");
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
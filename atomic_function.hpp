@@ -0,0 +1,180 @@
+#if !defined(ATOMIC_FUNCTION_HPP)
+#define ATOMIC_FUNCTION_HPP
+
+// A slot holding a callable that writers replace while readers keep
+// calling it without taking a lock, templated on the wrapper holding the
+// callable so that the implementations under test can be compared the way
+// hot-swapped strategy callbacks are stored.  Replaced callables are
+// reclaimed by epochs: a reader announces the epoch it entered in a slot
+// of its own, and a callable retired in an epoch is destroyed once no
+// reader is still in it.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace concurrent
+{
+    template<class F>
+    class atomic_function
+    {
+        struct node
+        {
+            explicit node(F&& f)
+              : fn(std::move(f))
+            {}
+
+            F fn;
+            std::uint64_t retired;
+        };
+
+        // The epoch a reader is in, or 0 between calls, on a cache line of
+        // its own so that readers don't write to each other's.
+        struct slot
+        {
+            alignas(64) std::atomic<std::uint64_t> epoch;
+            std::atomic<bool> taken;
+        };
+
+    public:
+        typedef F function_type;
+
+        // A reader's claim on one of the slots; a thread makes its calls
+        // through a reader of its own.
+        class reader
+        {
+        public:
+            explicit reader(atomic_function& af)
+              : af(af), s(af.claim())
+            {}
+
+            reader(reader const&) = delete;
+            reader& operator=(reader const&) = delete;
+
+            ~reader()
+            {
+                s->taken.store(false, std::memory_order_release);
+            }
+
+            // Calls the current callable.  It is called through a
+            // non-const path, as not every wrapper offers a const one, by
+            // many readers at once, so it must not change.
+            template<class... Args>
+            auto operator()(Args&&... args)
+                -> decltype(std::declval<F&>()(std::forward<Args>(args)...))
+            {
+                // An epoch a writer started was started after it published
+                // its callable, which the acquire makes visible.  Store and
+                // load are both seq_cst: a writer that missed the epoch
+                // announced here published before the load below.
+                s->epoch.store(af.epoch.load(std::memory_order_acquire));
+                struct leave
+                {
+                    ~leave()
+                    {
+                        s->epoch.store(0, std::memory_order_release);
+                    }
+
+                    slot* s;
+                } const guard = {s};
+                return af.current.load()->fn(std::forward<Args>(args)...);
+            }
+
+        private:
+            atomic_function& af;
+            slot* const s;
+        };
+
+        // At most readers readers at once.
+        explicit atomic_function(F f, std::size_t readers = 64)
+          : current(new node(std::move(f))), epoch(1), slots(readers)
+        {
+            for (slot& s : slots)
+            {
+                s.epoch.store(0, std::memory_order_relaxed);
+                s.taken.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        atomic_function(atomic_function const&) = delete;
+        atomic_function& operator=(atomic_function const&) = delete;
+
+        // No reader may be left.
+        ~atomic_function()
+        {
+            delete current.load(std::memory_order_relaxed);
+            for (node* n : retired)
+                delete n;
+        }
+
+        // Publishes f in place of the current callable, which is destroyed
+        // once the readers calling it are done; those that came later
+        // already call f.  Writers take turns.
+        void store(F f)
+        {
+            std::unique_ptr<node> n(new node(std::move(f)));
+            std::lock_guard<std::mutex> lock(writing);
+            node* const old = current.exchange(n.release());
+            old->retired = epoch.fetch_add(1);
+            retired.push_back(old);
+            reclaim();
+        }
+
+        // Callables replaced but not yet destroyed.
+        std::size_t pending() const
+        {
+            std::lock_guard<std::mutex> lock(writing);
+            return retired.size();
+        }
+
+    private:
+        slot* claim()
+        {
+            for (slot& s : slots)
+            {
+                bool free = false;
+                if (s.taken.compare_exchange_strong(free, true, std::memory_order_acquire))
+                    return &s;
+            }
+            throw std::length_error("atomic_function: too many readers");
+        }
+
+        // Destroys the callables retired in epochs no reader is in any
+        // more: a reader that entered later loads the callable that
+        // replaced them.
+        void reclaim()
+        {
+            std::uint64_t oldest = UINT64_MAX;
+            for (slot& s : slots)
+            {
+                std::uint64_t const e = s.epoch.load();
+                if (e != 0 && e < oldest)
+                    oldest = e;
+            }
+
+            std::size_t kept = 0;
+            for (node* n : retired)
+            {
+                if (n->retired < oldest)
+                    delete n;
+                else
+                    retired[kept++] = n;
+            }
+            retired.resize(kept);
+        }
+
+        std::atomic<node*> current;
+        std::atomic<std::uint64_t> epoch;
+        std::vector<slot> slots;
+        mutable std::mutex writing;
+        std::vector<node*> retired;
+    };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "dispatcher.hpp"
+#include "workload.hpp"
+
+
+// Lookups made by each timed run; one in MISS names no command.
+#define LOOKUPS (1 << 20)
+#define MISS 16
+
+typedef long handler(long);
+
+// Number of commands in every table.
+std::size_t commands;
+
+// Names made of a verb, an object and a number, as in
+// "cluster.node.status.17", most too long for the small string buffer.
+std::string command_name(std::size_t i)
+{
+    static char const* const objects[] = {"cluster", "node", "replica", "shard", "session", "user", "cache", "log"};
+    static char const* const verbs[] = {"status", "list", "reload", "drop", "stats", "flush", "get", "set"};
+    return std::string(objects[i % 8]) + "." + verbs[i / 8 % 8] + "." + std::to_string(i / 64);
+}
+
+// The names looked up by every case, in the same random order.
+std::vector<std::string> const& lookups()
+{
+    static std::vector<std::string> names;
+    static std::size_t made_for = 0;
+    if (made_for != commands)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<std::size_t> pick(0, commands - 1);
+        names.resize(LOOKUPS);
+        for (std::size_t i = 0; i != names.size(); ++i)
+            names[i] = i % MISS ? command_name(pick(gen)) : command_name(pick(gen)) + "?";
+        made_for = commands;
+    }
+    return names;
+}
+
+template<template<class> class Table>
+struct dispatching
+{
+    template<class F>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            std::vector<std::string> const& names = lookups();
+            std::size_t const before = test::allocated_bytes();
+            dispatch::commands<F> cs;
+            cs.reserve(commands);
+            for (std::size_t i = 0; i != commands; ++i)
+            {
+                long const k = static_cast<long>(i);
+                cs.emplace_back(command_name(i), F([k](long x) { return x * 31 + k; }));
+            }
+            Table<F> table(std::move(cs));
+            std::size_t const bytes = test::allocated_bytes() - before;
+
+            long x = 0;
+            double const elapsed = test::time_per_run([&]
+            {
+                for (std::string const& n : names)
+                {
+                    if (F* f = table.find(n))
+                        x = (*f)(x);
+                }
+            });
+
+            test::live_code += static_cast<int>(x);
+            test::report_rate(name, LOOKUPS / elapsed, "lookups");
+            std::cout << "{bytes/command: " << std::setprecision(1) << double(bytes) / commands
+                << ", size: " << sizeof(F) << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<handler> >)
+        (Case< std::function<handler> >)
+        (Case< cxx_function::function<handler> >)
+        (Case< cxx_function::unique_function<handler> >)
+        (Case< multifunction<handler> >)
+        (Case< boost::function<handler> >)
+        (Case< func::function<handler> >)
+        (Case< generic::delegate<handler> >)
+        (Case< fu2::function<handler> >)
+        (Case< fu2::unique_function<handler> >)
+        (Case< fixed_size_function<handler> >)
+        (Case< gnr_forwarder<handler> >)
+        (Case< embxx_util_StaticFunction<handler> >)
+        (Case< Function_<handler> >)
+        (Case< SmallFun<handler> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: commands [commands...], by default 16, 256 and 4096.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "commands: " << argv[i] << " is no number of commands\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {16, 256, 4096};
+
+    for (std::size_t size : sizes)
+    {
+        commands = size;
+        std::cout << "[" << commands << " commands]\n";
+        benchmark<dispatching<dispatch::hash_dispatcher>::with>("unordered_map");
+        benchmark<dispatching<dispatch::flat_dispatcher>::with>("sorted vector");
+        benchmark<dispatching<dispatch::perfect_dispatcher>::with>("perfect hash");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "team.hpp"
+#include "workload.hpp"
+
+
+// Copies made by every thread of each timed run.
+#define COPIES 100000
+
+typedef long handler(long);
+
+// Most threads copying the source at once; the cases run on 1, 2, 4...
+// threads up to that many.
+std::size_t most;
+
+// Small enough for the small buffer of every implementation.
+struct small
+{
+    long operator()(long x) const
+    {
+        return x * 3 + k;
+    }
+
+    long k;
+};
+
+// Too large for the small buffer of std::function and most others that
+// allocate, but still within the fixed capacity of those that cannot.
+struct large
+{
+    long operator()(long x) const
+    {
+        return x * 3 + k[0] + k[3];
+    }
+
+    long k[4];
+};
+
+// Every thread copies the same source, calls the copy once and destroys
+// it, so that all of them hit the source's reference count or the heap at
+// once.
+template<class Callable>
+struct copying
+{
+    template<class F>
+    struct with
+    {
+        static long copies(F const& source)
+        {
+            long sum = 0;
+            for (long i = 0; i != COPIES; ++i)
+            {
+                F copy(source);
+                sum += copy(i);
+            }
+            return sum;
+        }
+
+        // Times the copies from the moment every thread is ready to copy.
+        static double rate(F const& source, std::size_t threads)
+        {
+            std::atomic<long> sum(0);
+            concurrent::team team(threads);
+            double const elapsed = test::timed_per_run([&]
+            {
+                return team.run([&](std::size_t)
+                {
+                    sum += copies(source);
+                });
+            });
+            test::live_code += static_cast<int>(sum.load());
+            return threads * COPIES / elapsed;
+        }
+
+        static void run(char const* name)
+        {
+            F const source(Callable{{1}});
+            std::size_t const before = test::allocations();
+            test::live_code += static_cast<int>(copies(source));
+            std::size_t const allocations = test::allocations() - before;
+
+            double const single = rate(source, 1);
+            test::report_rate(name, single, "copies");
+            std::cout << "{allocations/copy: " << std::setprecision(2)
+                << double(allocations) / COPIES << ", scaling:";
+            for (std::size_t threads = 2; threads <= most; threads *= 2)
+                std::cout << " " << threads << " threads " << rate(source, threads) / single << "x";
+            std::cout << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<handler> >)
+        (Case< std::function<handler> >)
+        (Case< cxx_function::function<handler> >)
+        (Case< multifunction<handler> >)
+        (Case< boost::function<handler> >)
+        (Case< func::function<handler> >)
+        (Case< generic::delegate<handler> >)
+        (Case< fu2::function<handler> >)
+        (Case< fixed_size_function<handler> >)
+        (Case< gnr_forwarder<handler> >)
+        (Case< embxx_util_StaticFunction<handler> >)
+        (Case< Function_<handler> >)
+        (Case< SmallFun<handler> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: copies [threads], by default one per hardware thread.
+int main(int argc, char* argv[])
+{
+    most = argc > 1
+        ? std::strtoul(argv[1], nullptr, 10)
+        : std::thread::hardware_concurrency();
+    most = std::max<std::size_t>(most, 1);
+
+    benchmark<copying<small>::with>("small");
+    benchmark<copying<large>::with>("large");
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,255 @@
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "workload.hpp"
+
+
+// Awaits made by each timed run, spread over as many coroutines as the
+// number of awaits per coroutine allows.
+#define AWAITS 100000
+
+typedef void resumption();
+
+// Number of times every coroutine awaits its scheduler.
+std::size_t awaits;
+
+std::size_t coroutines()
+{
+    return awaits < AWAITS ? AWAITS / awaits : 1;
+}
+
+// Runs the resumption callbacks posted to it in order, including those
+// posted while it runs, until there are none left.
+template<class Callback>
+class scheduler
+{
+public:
+    void post(Callback c)
+    {
+        queue.push_back(std::move(c));
+    }
+
+    void run()
+    {
+        while (!queue.empty())
+        {
+            std::swap(queue, running);
+            for (Callback& c : running)
+                c();
+            running.clear();
+        }
+    }
+
+    void reserve(std::size_t n)
+    {
+        queue.reserve(n);
+        running.reserve(n);
+    }
+
+private:
+    std::vector<Callback> queue;
+    std::vector<Callback> running;
+};
+
+// A coroutine that starts right away and is destroyed by its owner.
+struct task
+{
+    struct promise_type
+    {
+        task get_return_object()
+        {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit task(std::coroutine_handle<promise_type> h)
+      : handle(h)
+    {}
+
+    task(task&& other)
+      : handle(std::exchange(other.handle, nullptr))
+    {}
+
+    task(task const&) = delete;
+
+    ~task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Suspends the coroutine and posts a callback holding its handle and a
+// pointer to the awaiter, which completes the operation and resumes it.
+template<class Callback>
+struct operation
+{
+    bool await_ready() const
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        operation* self = this;
+        sched->post(Callback([h, self]
+        {
+            self->result = self->input * 3 + 1;
+            h.resume();
+        }));
+    }
+
+    long await_resume() const
+    {
+        return result;
+    }
+
+    scheduler<Callback>* sched;
+    long input;
+    long result;
+};
+
+// The same, with the callback also carrying the operation's own state,
+// so that it outgrows the small buffer of some wrappers.
+template<class Callback>
+struct heavy_operation
+{
+    bool await_ready() const
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        long* out = &result;
+        long const a = input, b = input + 1;
+        sched->post(Callback([h, out, a, b]
+        {
+            *out = a * b + 1;
+            h.resume();
+        }));
+    }
+
+    long await_resume() const
+    {
+        return result;
+    }
+
+    scheduler<Callback>* sched;
+    long input;
+    long result;
+};
+
+template<template<class> class Operation, class Callback>
+task worker(scheduler<Callback>& sched, long id, long* total)
+{
+    for (std::size_t i = 0; i != awaits; ++i)
+        *total += co_await Operation<Callback>{&sched, id + static_cast<long>(i), 0};
+}
+
+// Starts every coroutine, each suspending on its first await, then lets
+// the scheduler resume them until they are all done.
+template<template<class> class Operation, class Callback>
+struct resume
+{
+    static void run(char const* name)
+    {
+        long total = 0;
+        scheduler<Callback> sched;
+        sched.reserve(coroutines());
+        // Reserved once, so that only the coroutines allocate.
+        std::vector<task> tasks;
+        tasks.reserve(coroutines());
+        auto const job = [&]
+        {
+            for (std::size_t i = 0; i != coroutines(); ++i)
+                tasks.push_back(worker<Operation>(sched, static_cast<long>(i), &total));
+            sched.run();
+            tasks.clear();
+        };
+        std::size_t const before = test::allocations();
+        job();
+        std::size_t const allocations = test::allocations() - before;
+        double const elapsed = test::time_per_run(job);
+
+        std::size_t const n = coroutines() * awaits;
+        test::live_code += static_cast<int>(total);
+        test::report_rate(name, n / elapsed, "resumes");
+        // One allocation per coroutine is its frame.
+        std::cout << "{size: " << sizeof(Callback) << ", allocations/await: "
+            << std::setprecision(2) << double(allocations - coroutines()) / n
+            << "}" << std::endl;
+    }
+};
+
+template<class Callback>
+using light = resume<operation, Callback>;
+
+template<class Callback>
+using heavy = resume<heavy_operation, Callback>;
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<resumption> >)
+        (Case< std::function<resumption> >)
+        (Case< cxx_function::function<resumption> >)
+        (Case< cxx_function::unique_function<resumption> >)
+        (Case< multifunction<resumption> >)
+        (Case< boost::function<resumption> >)
+        (Case< func::function<resumption> >)
+        (Case< generic::delegate<resumption> >)
+        (Case< fu2::function<resumption> >)
+        (Case< fu2::unique_function<resumption> >)
+        (Case< fixed_size_function<resumption> >)
+        (Case< gnr_forwarder<resumption> >)
+        (Case< embxx_util_StaticFunction<resumption> >)
+        (Case< Function_<resumption> >)
+        (Case< SmallFun<resumption> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: coroutines [awaits...], by default 1, 10 and 1000 awaits per
+// coroutine.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "coroutines: " << argv[i] << " is no number of awaits\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1, 10, 1000};
+
+    for (std::size_t size : sizes)
+    {
+        awaits = size;
+        std::cout << "[" << awaits << " await" << (awaits == 1 ? "" : "s") << " per coroutine]\n";
+        benchmark<light>("handle and awaiter");
+        benchmark<heavy>("handle and state");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
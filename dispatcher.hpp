@@ -0,0 +1,189 @@
+#if !defined(DISPATCHER_HPP)
+#define DISPATCHER_HPP
+
+// Tables mapping command names to the callbacks handling them, templated
+// on the wrapper holding the callbacks, so that the implementations under
+// test can be compared the way admin and RPC handlers look them up.  All
+// of them are built once from the whole set of commands and offer
+//
+//     F* find(std::string const& name);
+//
+// returning the callback for name, or nullptr if there is none.  It isn't
+// const, as not every wrapper can be called through a const path.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace dispatch
+{
+    template<class F>
+    using commands = std::vector<std::pair<std::string, F> >;
+
+    template<class F>
+    class hash_dispatcher
+    {
+    public:
+        explicit hash_dispatcher(commands<F> cs)
+        {
+            table.reserve(cs.size());
+            for (std::pair<std::string, F>& c : cs)
+                table.emplace(std::move(c.first), std::move(c.second));
+        }
+
+        F* find(std::string const& name)
+        {
+            typename std::unordered_map<std::string, F>::iterator it = table.find(name);
+            return it != table.end() ? &it->second : nullptr;
+        }
+
+    private:
+        std::unordered_map<std::string, F> table;
+    };
+
+    // Sorted by name and searched by bisection.
+    template<class F>
+    class flat_dispatcher
+    {
+    public:
+        // Sorts the names rather than the commands, as not every wrapper
+        // can be swapped.
+        explicit flat_dispatcher(commands<F> cs)
+        {
+            std::vector<std::size_t> order(cs.size());
+            for (std::size_t i = 0; i != order.size(); ++i)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+            {
+                return cs[a].first < cs[b].first;
+            });
+            table.reserve(cs.size());
+            for (std::size_t i : order)
+                table.push_back(std::move(cs[i]));
+        }
+
+        F* find(std::string const& name)
+        {
+            typename commands<F>::iterator it = std::lower_bound(
+                table.begin(), table.end(), name,
+                [](std::pair<std::string, F> const& c, std::string const& n)
+                {
+                    return c.first < n;
+                });
+            return it != table.end() && it->first == name ? &it->second : nullptr;
+        }
+
+    private:
+        commands<F> table;
+    };
+
+    // A perfect hash by hash and displace: names are spread over buckets
+    // by one hash, then every bucket, largest first, gets the seed of a
+    // second hash placing all its names in free slots.  A lookup is two
+    // hashes, one name comparison and never a probe.  Names must not be
+    // empty, as empty slots have an empty name.
+    template<class F>
+    class perfect_dispatcher
+    {
+    public:
+        explicit perfect_dispatcher(commands<F> cs)
+        {
+            std::size_t slots = 1;
+            while (slots < cs.size())
+                slots *= 2;
+            while (!build(cs, slots))
+                slots *= 2;
+
+            table.resize(slots);
+            for (std::pair<std::string, F>& c : cs)
+                table[slot_of(c.first)] = std::move(c);
+        }
+
+        F* find(std::string const& name)
+        {
+            std::pair<std::string, F>& c = table[slot_of(name)];
+            return c.first == name ? &c.second : nullptr;
+        }
+
+    private:
+        // Seeds tried for a bucket before giving up on the table size.
+        static const std::uint32_t TRIES = 1 << 16;
+
+        // FNV-1a, starting from a basis altered by seed.
+        static std::uint64_t hash(std::string const& s, std::uint64_t seed)
+        {
+            std::uint64_t h = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+            for (char c : s)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 1099511628211ull;
+            }
+            return h ^ (h >> 29);
+        }
+
+        std::size_t slot_of(std::string const& name) const
+        {
+            std::uint32_t const seed = seeds[hash(name, 0) & (seeds.size() - 1)];
+            return hash(name, seed) & (table.size() - 1);
+        }
+
+        // Finds a seed for every bucket with slots slots; the table is
+        // resized by the caller once they are all found.
+        bool build(commands<F> const& cs, std::size_t slots)
+        {
+            std::size_t buckets = 1;
+            while (buckets * 4 < slots)
+                buckets *= 2;
+            seeds.assign(buckets, 0);
+
+            std::vector<std::vector<std::size_t> > members(buckets);
+            for (std::size_t i = 0; i != cs.size(); ++i)
+                members[hash(cs[i].first, 0) & (buckets - 1)].push_back(i);
+            std::vector<std::size_t> order(buckets);
+            for (std::size_t b = 0; b != buckets; ++b)
+                order[b] = b;
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+            {
+                return members[a].size() > members[b].size();
+            });
+
+            std::vector<bool> taken(slots, false);
+            std::vector<std::size_t> placed;
+            for (std::size_t b : order)
+            {
+                if (members[b].empty())
+                    break;
+                std::uint32_t seed = 1;
+                for (; seed != TRIES; ++seed)
+                {
+                    placed.clear();
+                    for (std::size_t i : members[b])
+                    {
+                        std::size_t const s = hash(cs[i].first, seed) & (slots - 1);
+                        if (taken[s] || std::find(placed.begin(), placed.end(), s) != placed.end())
+                            break;
+                        placed.push_back(s);
+                    }
+                    if (placed.size() == members[b].size())
+                        break;
+                }
+                if (seed == TRIES)
+                    return false;
+                seeds[b] = seed;
+                for (std::size_t s : placed)
+                    taken[s] = true;
+            }
+            return true;
+        }
+
+        std::vector<std::uint32_t> seeds;
+        commands<F> table;
+    };
+}
+
+#endif
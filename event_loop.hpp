@@ -0,0 +1,137 @@
+#if !defined(EVENT_LOOP_HPP)
+#define EVENT_LOOP_HPP
+
+// A minimal single-threaded epoll reactor, templated on the wrapper holding
+// the callback each registered file descriptor owns, so that the
+// implementations under test can be compared next to real system calls.
+// Linux only.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+
+namespace reactor
+{
+    template<class Callback>
+    class event_loop
+    {
+    public:
+        // Events handed out by one call to epoll_wait at most.
+        static const int BATCH = 64;
+
+        event_loop()
+          : epoll(::epoll_create1(EPOLL_CLOEXEC)), registered(0), dispatching(false)
+        {
+            if (epoll < 0)
+                throw std::system_error(errno, std::system_category(), "epoll_create1");
+        }
+
+        event_loop(event_loop const&) = delete;
+        event_loop& operator=(event_loop const&) = delete;
+
+        ~event_loop()
+        {
+            ::close(epoll);
+        }
+
+        // Calls fn, held in a Callback, with the events that occurred
+        // whenever fd is ready for any of events.  Callbacks are kept in a
+        // table indexed by descriptor, so a callback may remove
+        // registrations but must not add any.
+        template<class Fn>
+        void add(int fd, std::uint32_t events, Fn fn)
+        {
+            if (static_cast<std::size_t>(fd) >= callbacks.size())
+                callbacks.resize(fd + 1);
+            callbacks[fd] = Callback(std::move(fn));
+
+            epoll_event e = {};
+            e.events = events;
+            e.data.fd = fd;
+            if (::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &e) < 0)
+            {
+                callbacks[fd] = Callback();
+                throw std::system_error(errno, std::system_category(), "epoll_ctl");
+            }
+            ++registered;
+        }
+
+        // Events already returned for fd by the current wait are dropped.
+        // During a dispatch the callback is only destroyed once it is
+        // over, as it may be the one running.
+        void remove(int fd)
+        {
+            if (::epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr) < 0)
+                throw std::system_error(errno, std::system_category(), "epoll_ctl");
+            if (dispatching)
+                removed.push_back(fd);
+            else
+                callbacks[fd] = Callback();
+            --registered;
+        }
+
+        // Waits up to timeout milliseconds, -1 meaning forever, for events
+        // and dispatches them.  Returns how many were dispatched.
+        std::size_t run_once(int timeout)
+        {
+            epoll_event events[BATCH];
+            int n = ::epoll_wait(epoll, events, BATCH, timeout);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    return 0;
+                throw std::system_error(errno, std::system_category(), "epoll_wait");
+            }
+
+            std::size_t dispatched = 0;
+            dispatching = true;
+            for (int i = 0; i != n; ++i)
+            {
+                // epoll_event is packed on x86-64, so its members are
+                // copied rather than bound to the callback's parameters.
+                int const fd = events[i].data.fd;
+                std::uint32_t const ready = events[i].events;
+                if (!removed.empty() && is_removed(fd))
+                    continue;
+                callbacks[fd](ready);
+                ++dispatched;
+            }
+            dispatching = false;
+            for (int fd : removed)
+                callbacks[fd] = Callback();
+            removed.clear();
+            return dispatched;
+        }
+
+        std::size_t size() const
+        {
+            return registered;
+        }
+
+    private:
+        bool is_removed(int fd) const
+        {
+            for (int r : removed)
+            {
+                if (r == fd)
+                    return true;
+            }
+            return false;
+        }
+
+        std::vector<Callback> callbacks;
+        // Descriptors removed during the current dispatch.
+        std::vector<int> removed;
+        int epoll;
+        std::size_t registered;
+        bool dispatching;
+    };
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <system_error>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "event_loop.hpp"
+#include "workload.hpp"
+
+
+// Events dispatched by each timed run.
+#define EVENTS 100000
+
+typedef void handler(std::uint32_t);
+
+// Number of event sources registered by each case.
+std::size_t sources;
+
+// Time per event of the callback called directly, which the other
+// implementations are compared against.
+double baseline;
+
+// An eventfd in semaphore mode, so that every signal is one event.
+struct eventfd_source
+{
+    // Bytes read or written per event.
+    static const ssize_t width = sizeof(std::uint64_t);
+
+    eventfd_source()
+      : in(::eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE | EFD_CLOEXEC)), out(in)
+    {
+        if (in < 0)
+            throw std::system_error(errno, std::system_category(), "eventfd");
+    }
+
+    eventfd_source(eventfd_source const&) = delete;
+
+    ~eventfd_source()
+    {
+        ::close(in);
+    }
+
+    int in;
+    int out;
+};
+
+// A pipe, every byte written to it being one event.
+struct pipe_source
+{
+    static const ssize_t width = 1;
+
+    pipe_source()
+    {
+        int fds[2];
+        if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+            throw std::system_error(errno, std::system_category(), "pipe2");
+        in = fds[0];
+        out = fds[1];
+    }
+
+    pipe_source(pipe_source const&) = delete;
+
+    ~pipe_source()
+    {
+        ::close(in);
+        ::close(out);
+    }
+
+    int in;
+    int out;
+};
+
+void consume(int fd, ssize_t width)
+{
+    std::uint64_t v;
+    if (::read(fd, &v, width) != width)
+        throw std::system_error(errno, std::system_category(), "read");
+}
+
+void signal(int fd, ssize_t width)
+{
+    std::uint64_t const v = 1;
+    if (::write(fd, &v, width) != width)
+        throw std::system_error(errno, std::system_category(), "write");
+}
+
+// The callback every implementation holds: consumes the event of its
+// source and passes it on to the next one, so that as many events as
+// sources keep going round.
+struct no_abstraction
+{
+    void operator()(std::uint32_t) const
+    {
+        consume(in, width);
+        signal(next, width);
+        ++*count;
+    }
+
+    int in;
+    int next;
+    ssize_t width;
+    std::size_t* count;
+};
+
+template<class Source>
+struct ring
+{
+    template<class Callback>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            std::vector<Source> ends(sources);
+            reactor::event_loop<Callback> loop;
+            std::size_t count = 0;
+            for (std::size_t i = 0; i != sources; ++i)
+            {
+                loop.add(ends[i].in, EPOLLIN, no_abstraction{
+                    ends[i].in, ends[(i + 1) % sources].out, Source::width, &count});
+                signal(ends[i].out, Source::width);
+            }
+
+            std::size_t waits = 0;
+            std::size_t const before = count;
+            double const elapsed = test::time_per_run([&]
+            {
+                std::size_t const until = count + EVENTS;
+                while (count < until)
+                {
+                    loop.run_once(-1);
+                    ++waits;
+                }
+            });
+
+            double const per_event = elapsed / EVENTS * 1e9;
+            test::live_code += static_cast<int>(count);
+            test::report_rate(name, EVENTS / elapsed, "events");
+            std::cout << "{ns/event: " << std::setprecision(1) << per_event;
+            if (baseline)
+                std::cout << ", overhead: " << per_event - baseline << " ns";
+            else
+                baseline = per_event;
+            std::cout << ", events/wait: " << double(count - before) / waits
+                << ", size: " << sizeof(Callback) << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    baseline = 0;
+    WORKLOAD_BENCHMARK(
+        (Case< no_abstraction >)
+        (Case< stdex::function<handler> >)
+        (Case< std::function<handler> >)
+        (Case< cxx_function::function<handler> >)
+        (Case< cxx_function::unique_function<handler> >)
+        (Case< multifunction<handler> >)
+        (Case< boost::function<handler> >)
+        (Case< func::function<handler> >)
+        (Case< generic::delegate<handler> >)
+        (Case< fu2::function<handler> >)
+        (Case< fu2::unique_function<handler> >)
+        (Case< fixed_size_function<handler> >)
+        (Case< gnr_forwarder<handler> >)
+        (Case< embxx_util_StaticFunction<handler> >)
+        (Case< Function_<handler> >)
+        (Case< SmallFun<handler> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: events [sources...], by default 1, 16 and 256.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "events: " << argv[i] << " is no number of sources\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1, 16, 256};
+
+    for (std::size_t size : sizes)
+    {
+        sources = size;
+        std::cout << "[" << sources << " source" << (sources == 1 ? "" : "s") << "]\n";
+        benchmark<ring<eventfd_source>::with>("eventfd");
+        benchmark<ring<pipe_source>::with>("pipe");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "work_stealing_pool.hpp"
+#include "workload.hpp"
+
+
+// fib(FIB) spawns a task for every call but the leaves.
+#define FIB 27
+// parallel_for splits ELEMENTS in halves down to GRAIN elements.
+#define ELEMENTS (1 << 20)
+#define GRAIN 256
+
+
+typedef void job();
+typedef void loop_body(std::size_t, std::size_t);
+
+// fixed_size_function at its default capacity, as a template of the
+// signature alone.
+template<class Sig>
+using fixed_size_function_ = fixed_size_function<Sig>;
+
+// The wrapper under test holding the tasks and the bodies of parallel
+// fors.
+template<template<class...> class Function>
+struct wrapping
+{
+    typedef Function<job> task;
+    typedef Function<loop_body> loop;
+};
+
+// Number of workers of every pool, the calling thread included.
+std::size_t workers;
+
+// Runs job on a pool with a single worker, where every task runs on the
+// calling thread, and returns the allocations it made.
+template<class Task, class Job>
+std::size_t allocations_of(Job job)
+{
+    concurrent::work_stealing_pool<Task> pool(1);
+    std::size_t const before = test::allocations();
+    job(pool);
+    return test::allocations() - before;
+}
+
+template<class Task>
+void report(char const* name, double rate, char const* unit,
+    std::size_t allocations, std::size_t tasks, unsigned long checksum)
+{
+    test::report_rate(name, rate, unit);
+    std::cout << "{size: " << sizeof(Task) << ", allocations/task: "
+        << std::setprecision(2) << double(allocations) / tasks
+        << ", checksum: " << std::hex << checksum << std::dec << "}" << std::endl;
+}
+
+// Spawns fib(n - 1) and computes fib(n - 2) itself, then waits for the
+// task it spawned, running other tasks in the meantime.
+template<class Wrapping>
+struct fib
+{
+    typedef typename Wrapping::task Task;
+
+    static long compute(concurrent::work_stealing_pool<Task>& pool, int n)
+    {
+        if (n < 2)
+            return n;
+
+        long x = 0;
+        std::atomic<bool> done(false);
+        pool.spawn(Task([&pool, n, &x, &done]
+        {
+            x = compute(pool, n - 1);
+            done.store(true, std::memory_order_release);
+        }));
+        long const y = compute(pool, n - 2);
+        pool.wait_until([&done] { return done.load(std::memory_order_acquire); });
+        return x + y;
+    }
+
+    static std::size_t spawns(int n)
+    {
+        return n < 2 ? 0 : 1 + spawns(n - 1) + spawns(n - 2);
+    }
+
+    static void run(char const* name)
+    {
+        long result = 0;
+        auto const job = [&result](concurrent::work_stealing_pool<Task>& pool)
+        {
+            pool.run([&] { result = compute(pool, FIB); });
+        };
+        std::size_t const allocations = allocations_of<Task>(job);
+
+        concurrent::work_stealing_pool<Task> pool(workers);
+        double const elapsed = test::time_per_run([&] { job(pool); });
+
+        std::size_t const tasks = spawns(FIB);
+        test::live_code += static_cast<int>(result);
+        report<Task>(name, tasks / elapsed, "tasks", allocations, tasks, result);
+    }
+};
+
+// Splits [begin, end) in halves, spawning the upper one, down to GRAIN
+// elements handed to body, which the tasks refer to.  The body is called
+// through a non-const path, as not every wrapper offers a const one.
+template<class Task, class Body>
+void parallel_for(concurrent::work_stealing_pool<Task>& pool,
+    std::size_t begin, std::size_t end, Body& body)
+{
+    if (end - begin <= GRAIN)
+    {
+        body(begin, end);
+        return;
+    }
+
+    std::size_t const middle = begin + (end - begin) / 2;
+    std::atomic<bool> done(false);
+    pool.spawn(Task([&pool, middle, end, &body, &done]
+    {
+        parallel_for(pool, middle, end, body);
+        done.store(true, std::memory_order_release);
+    }));
+    parallel_for(pool, begin, middle, body);
+    pool.wait_until([&done] { return done.load(std::memory_order_acquire); });
+}
+
+template<class Wrapping>
+struct for_each
+{
+    typedef typename Wrapping::task Task;
+
+    static void run(char const* name)
+    {
+        std::vector<unsigned> in(ELEMENTS), out(ELEMENTS);
+        for (std::size_t i = 0; i != in.size(); ++i)
+            in[i] = static_cast<unsigned>(i);
+
+        typename Wrapping::loop body([&in, &out](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i != end; ++i)
+                out[i] = in[i] * 3 + 1;
+        });
+        auto const job = [&body](concurrent::work_stealing_pool<Task>& pool)
+        {
+            pool.run([&] { parallel_for(pool, 0, ELEMENTS, body); });
+        };
+        std::size_t const allocations = allocations_of<Task>(job);
+
+        concurrent::work_stealing_pool<Task> pool(workers);
+        double const elapsed = test::time_per_run([&] { job(pool); });
+
+        unsigned long checksum = 0;
+        for (unsigned v : out)
+            checksum += v;
+        std::size_t const tasks = ELEMENTS / GRAIN - 1;
+        test::live_code += static_cast<int>(checksum);
+        report<Task>(name, ELEMENTS / elapsed, "elements", allocations, tasks, checksum);
+    }
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< wrapping<stdex::function> >)
+        (Case< wrapping<std::function> >)
+        (Case< wrapping<cxx_function::function> >)
+        (Case< wrapping<cxx_function::unique_function> >)
+        (Case< wrapping<multifunction> >)
+        (Case< wrapping<boost::function> >)
+        (Case< wrapping<func::function> >)
+        (Case< wrapping<generic::delegate> >)
+        (Case< wrapping<fu2::function> >)
+        (Case< wrapping<fu2::unique_function> >)
+        (Case< wrapping<fixed_size_function_> >)
+        (Case< wrapping<gnr_forwarder> >)
+        (Case< wrapping<embxx_util_StaticFunction> >)
+        (Case< wrapping<Function_> >)
+        (Case< wrapping<SmallFun> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: fork_join [workers], by default one per hardware thread.
+int main(int argc, char* argv[])
+{
+    workers = argc > 1
+        ? std::strtoul(argv[1], nullptr, 10)
+        : std::thread::hardware_concurrency();
+    workers = std::max<std::size_t>(workers, 1);
+
+    std::cout << "[" << workers << " worker" << (workers == 1 ? "" : "s") << "]\n";
+    benchmark<fib>("fib");
+    benchmark<for_each>("parallel for");
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
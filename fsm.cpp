@@ -0,0 +1,211 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "state_machine.hpp"
+#include "workload.hpp"
+
+
+#define STATES 32
+#define INPUTS 16
+// Length of every input stream.
+#define STREAM (1 << 20)
+
+typedef void action(std::size_t);
+
+// Number of machines, each with its own table, the stream is dealt to in
+// turn by each case; their tables make up the working set.
+std::size_t machines;
+
+// What the actions of one machine update.
+struct context
+{
+    std::uint64_t count;
+    std::uint64_t sum;
+    std::uint64_t hash;
+};
+
+// Uniformly random inputs.
+std::vector<std::uint8_t> random_stream()
+{
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> input(0, INPUTS - 1);
+    std::vector<std::uint8_t> stream(STREAM);
+    for (std::uint8_t& i : stream)
+        i = static_cast<std::uint8_t>(input(gen));
+    return stream;
+}
+
+// HTTP requests mapped to character classes, as a lexer would feed its
+// parser: skewed and repetitive.
+std::vector<std::uint8_t> text_stream()
+{
+    static char const* const paths[] = {"/", "/index.html", "/api/v1/users/42", "/static/app.js"};
+    static char const* const agents[] = {"curl/8.0", "Mozilla/5.0 (X11; Linux x86_64)"};
+    std::mt19937 gen(7);
+    std::string text;
+    while (text.size() < STREAM)
+    {
+        text += gen() % 4 ? "GET " : "POST ";
+        text += paths[gen() % 4];
+        text += " HTTP/1.1\r\nHost: example.com:8080\r\nUser-Agent: ";
+        text += agents[gen() % 2];
+        text += "\r\nContent-Length: " + std::to_string(gen() % 10000) + "\r\n\r\n";
+    }
+
+    std::vector<std::uint8_t> stream(STREAM);
+    for (std::size_t i = 0; i != stream.size(); ++i)
+    {
+        char const c = text[i];
+        stream[i] =
+            c >= 'a' && c <= 'z' ? 0 :
+            c >= 'A' && c <= 'Z' ? 1 :
+            c >= '0' && c <= '9' ? 2 :
+            c == ' ' ? 3 : c == '\r' ? 4 : c == '\n' ? 5 : c == ':' ? 6 :
+            c == '/' ? 7 : c == '.' ? 8 : c == '-' ? 9 : c == '(' ? 10 :
+            c == ')' ? 11 : c == ';' ? 12 : c == '_' ? 13 : c == ',' ? 14 : 15;
+    }
+    return stream;
+}
+
+// Every transition goes to a random state and gets one of four actions at
+// random, the last of which captures too much for the small buffer of
+// some implementations.  The layout is the same for every implementation.
+template<class Machine>
+void build(Machine& m, context* ctx, std::mt19937& gen)
+{
+    for (std::size_t s = 0; s != STATES; ++s)
+    {
+        for (std::size_t i = 0; i != INPUTS; ++i)
+        {
+            std::size_t const next = gen() % STATES;
+            std::uint64_t const k = gen() | 1;
+            switch (gen() % 4)
+            {
+            case 0:
+                m.on(s, i, next, [ctx](std::size_t) { ++ctx->count; });
+                break;
+            case 1:
+                m.on(s, i, next, [ctx, k](std::size_t in) { ctx->sum += in * k; });
+                break;
+            case 2:
+                m.on(s, i, next, [ctx, k](std::size_t in) { ctx->hash = (ctx->hash ^ in) * k; });
+                break;
+            default:
+                std::uint64_t const a = k >> 7, b = k >> 13;
+                m.on(s, i, next, [ctx, k, a, b](std::size_t in)
+                {
+                    ctx->sum += in * a;
+                    ctx->hash = (ctx->hash + b) * k;
+                });
+                break;
+            }
+        }
+    }
+}
+
+template<bool Text>
+struct feed
+{
+    template<class Action>
+    struct with
+    {
+        typedef fsm::state_machine<Action, STATES, INPUTS> machine;
+
+        static void run(char const* name)
+        {
+            static std::vector<std::uint8_t> const stream = Text ? text_stream() : random_stream();
+
+            std::vector<context> contexts(machines, context{0, 0, 0});
+            std::vector<std::unique_ptr<machine> > ms;
+            ms.reserve(machines);
+            std::mt19937 gen(42);
+            std::size_t const before = test::allocated_bytes();
+            for (std::size_t i = 0; i != machines; ++i)
+            {
+                ms.emplace_back(new machine);
+                build(*ms.back(), &contexts[i], gen);
+            }
+            std::size_t const bytes = (test::allocated_bytes() - before) / machines;
+
+            std::size_t states = 0;
+            double const elapsed = test::time_per_run([&]
+            {
+                std::size_t m = 0;
+                for (std::uint8_t input : stream)
+                {
+                    states += ms[m]->step(input);
+                    if (++m == machines)
+                        m = 0;
+                }
+            });
+
+            std::uint64_t checksum = states;
+            for (context const& c : contexts)
+                checksum += c.count + c.sum + c.hash;
+            test::live_code += static_cast<int>(checksum);
+            test::report_rate(name, STREAM / elapsed, "transitions");
+            std::cout << "{table: " << std::setprecision(1) << bytes / 1024.0
+                << " KB, working set: " << bytes * machines / 1024.0
+                << " KB, size: " << sizeof(Action) << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<action> >)
+        (Case< std::function<action> >)
+        (Case< cxx_function::function<action> >)
+        (Case< cxx_function::unique_function<action> >)
+        (Case< multifunction<action> >)
+        (Case< boost::function<action> >)
+        (Case< func::function<action> >)
+        (Case< generic::delegate<action> >)
+        (Case< fu2::function<action> >)
+        (Case< fu2::unique_function<action> >)
+        (Case< fixed_size_function<action> >)
+        (Case< gnr_forwarder<action> >)
+        (Case< embxx_util_StaticFunction<action> >)
+        (Case< Function_<action> >)
+        (Case< SmallFun<action> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: fsm [machines...], by default 1, 16 and 256.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "fsm: " << argv[i] << " is no number of machines\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1, 16, 256};
+
+    for (std::size_t size : sizes)
+    {
+        machines = size;
+        std::cout << "[" << machines << " machine" << (machines == 1 ? "" : "s") << "]\n";
+        benchmark<feed<false>::with>("random");
+        benchmark<feed<true>::with>("http");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,269 @@
+#if !defined(FUTURE_HPP)
+#define FUTURE_HPP
+
+// A minimal future/promise pair, templated on the wrapper holding the
+// continuation attached by then(), so that the implementations under test
+// can be compared the way an RPC layer chains its continuations: each one
+// stored once and called once.
+
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+
+namespace async
+{
+    // For futures that are only ever used from one thread.
+    struct single_thread
+    {
+        class flags
+        {
+        public:
+            // Sets the given bits and returns the ones set before.
+            unsigned set(unsigned bits)
+            {
+                unsigned const old = value;
+                value |= bits;
+                return old;
+            }
+
+        private:
+            unsigned value = 0;
+        };
+
+        class count
+        {
+        public:
+            explicit count(unsigned n)
+              : value(n)
+            {}
+
+            // Returns whether the last reference was dropped.
+            bool drop()
+            {
+                return --value == 0;
+            }
+
+        private:
+            unsigned value;
+        };
+    };
+
+    // For futures whose promise is fulfilled on another thread than the
+    // one attaching the continuation.
+    struct cross_thread
+    {
+        class flags
+        {
+        public:
+            unsigned set(unsigned bits)
+            {
+                return value.fetch_or(bits, std::memory_order_acq_rel);
+            }
+
+        private:
+            std::atomic<unsigned> value{0};
+        };
+
+        class count
+        {
+        public:
+            explicit count(unsigned n)
+              : value(n)
+            {}
+
+            bool drop()
+            {
+                return value.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+
+        private:
+            std::atomic<unsigned> value;
+        };
+    };
+
+    template<class T, class Callback, class Sync>
+    class promise;
+
+    // The value and the continuation of a promise, shared with its
+    // future.  Whichever of set_value() and then() comes second calls the
+    // continuation.
+    template<class T, class Callback, class Sync>
+    class shared_state
+    {
+    public:
+        shared_state()
+          : successor(nullptr), references(2)
+        {}
+
+        shared_state(shared_state const&) = delete;
+        shared_state& operator=(shared_state const&) = delete;
+
+        // Drops a reference, and the successors this one kept alive in
+        // turn, without recursing along a chain of any length.
+        void release()
+        {
+            shared_state* s = this;
+            while (s && s->references.drop())
+            {
+                shared_state* const next = s->successor;
+                delete s;
+                s = next;
+            }
+        }
+
+        void set_value(T v)
+        {
+            value = std::move(v);
+            if (progress.set(VALUE) & CONTINUATION)
+                continuation(std::move(value));
+        }
+
+        // Keeps next alive until this state goes, so that the
+        // continuation can refer to it by a plain pointer, whichever
+        // wrapper holds it and however often that one copies it.
+        template<class Fn>
+        void attach(shared_state* next, Fn&& fn)
+        {
+            successor = next;
+            attach(std::forward<Fn>(fn));
+        }
+
+        template<class Fn>
+        void attach(Fn&& fn)
+        {
+            continuation = Callback(std::forward<Fn>(fn));
+            if (progress.set(CONTINUATION) & VALUE)
+                continuation(std::move(value));
+        }
+
+    private:
+        static const unsigned VALUE = 1;
+        static const unsigned CONTINUATION = 2;
+
+        T value;
+        Callback continuation;
+        shared_state* successor;
+        typename Sync::flags progress;
+        typename Sync::count references;
+    };
+
+    template<class T, class Callback, class Sync = single_thread>
+    class future
+    {
+    public:
+        future(future const&) = delete;
+        future& operator=(future const&) = delete;
+
+        future(future&& other)
+          : state(other.state)
+        {
+            other.state = nullptr;
+        }
+
+        future& operator=(future&& other)
+        {
+            std::swap(state, other.state);
+            return *this;
+        }
+
+        ~future()
+        {
+            if (state)
+                state->release();
+        }
+
+        bool valid() const
+        {
+            return state != nullptr;
+        }
+
+        // Attaches fn, held in a Callback along with the state of the
+        // future returned, and leaves this future invalid.  fn is called
+        // with the value once it is set, on the thread setting it or, if
+        // it is set already, right away.
+        template<class Fn>
+        future then(Fn fn)
+        {
+            assert(valid());
+            shared_state<T, Callback, Sync>* next = new shared_state<T, Callback, Sync>;
+            future result(next);
+            shared_state<T, Callback, Sync>* s = state;
+            state = nullptr;
+            s->attach(next, [next, fn = std::move(fn)](T v)
+            {
+                next->set_value(fn(std::move(v)));
+            });
+            s->release();
+            return result;
+        }
+
+        // Calls fn with the value, with no future to follow.
+        template<class Fn>
+        void finally(Fn fn)
+        {
+            assert(valid());
+            shared_state<T, Callback, Sync>* s = state;
+            state = nullptr;
+            s->attach(std::move(fn));
+            s->release();
+        }
+
+    private:
+        friend class promise<T, Callback, Sync>;
+
+        explicit future(shared_state<T, Callback, Sync>* s)
+          : state(s)
+        {}
+
+        shared_state<T, Callback, Sync>* state;
+    };
+
+    // The value must be set once.
+    template<class T, class Callback, class Sync = single_thread>
+    class promise
+    {
+    public:
+        promise()
+          : state(new shared_state<T, Callback, Sync>)
+        {}
+
+        promise(promise const&) = delete;
+        promise& operator=(promise const&) = delete;
+
+        promise(promise&& other)
+          : state(other.state)
+        {
+            other.state = nullptr;
+        }
+
+        promise& operator=(promise&& other)
+        {
+            std::swap(state, other.state);
+            return *this;
+        }
+
+        ~promise()
+        {
+            if (state)
+                state->release();
+        }
+
+        // Can only be called once; the state starts out with a reference
+        // held for the future.
+        future<T, Callback, Sync> get_future()
+        {
+            return future<T, Callback, Sync>(state);
+        }
+
+        void set_value(T v) const
+        {
+            state->set_value(std::move(v));
+        }
+
+    private:
+        shared_state<T, Callback, Sync>* state;
+    };
+}
+
+#endif
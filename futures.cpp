@@ -0,0 +1,270 @@
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "future.hpp"
+#include "workload.hpp"
+
+
+// Continuations attached by each timed run, spread over as many chains as
+// the chain length allows.
+#define CONTINUATIONS 100000
+// Longest chain taken from the command line.  Setting a value runs the
+// whole chain in nested calls, one or more stack frames per continuation.
+#define MAX_LENGTH 100000
+
+typedef void continuation(long);
+
+template<class Sig>
+using fixed_size_function_move =
+    fixed_size_function<Sig, 128, construct_type::move>;
+
+// Number of continuations chained to every promise by each case.
+std::size_t length;
+
+std::size_t chains()
+{
+    return length < CONTINUATIONS ? CONTINUATIONS / length : 1;
+}
+
+// Every continuation of a chain adds its own constant to the value.
+struct step
+{
+    long operator()(long v) const
+    {
+        return v + k;
+    }
+
+    long k;
+};
+
+// The same, for the wrappers that can hold a callable that can't be copied.
+struct move_only_step
+{
+    explicit move_only_step(long k)
+      : k(k)
+    {}
+
+    move_only_step(move_only_step&&) = default;
+    move_only_step(move_only_step const&) = delete;
+
+    long operator()(long v) const
+    {
+        return v + k;
+    }
+
+    long k;
+};
+
+// Chains length continuations made of Step, then one storing the result,
+// to the future of p.
+template<class Step, class Callback, class Sync>
+void attach(async::promise<long, Callback, Sync>& p, long* result)
+{
+    async::future<long, Callback, Sync> f = p.get_future();
+    for (std::size_t i = 0; i != length; ++i)
+        f = f.then(Step{static_cast<long>(i)});
+    f.finally([result](long v) { *result = v; });
+}
+
+template<class Callback>
+void report(char const* name, double attaching, double completing,
+    std::size_t allocations, std::vector<long> const& results)
+{
+    unsigned long checksum = 0;
+    for (long r : results)
+        checksum += r;
+    test::live_code += static_cast<int>(checksum);
+
+    double const n = double(chains() * length);
+    test::report_rate(name, n / attaching, "attaches");
+    if (completing)
+        std::cout << n / completing / 1e6 << " [Mcompletions/s] ";
+    std::cout << "{size: " << sizeof(Callback) << ", allocations/continuation: "
+        << std::setprecision(2) << allocations / n
+        << ", checksum: " << std::hex << checksum << std::dec << "}" << std::endl;
+}
+
+// Attaches every chain to a pending promise, then fulfils the promises,
+// which runs the chains, until a second has been spent.
+template<class Callback, class Step>
+struct chained
+{
+    static void run(char const* name)
+    {
+        typedef async::promise<long, Callback, async::single_thread> promise;
+        std::vector<long> results(chains());
+        std::size_t allocations = 0;
+        double attaching = 0, completing = 0;
+        long runs = 0;
+        do
+        {
+            std::size_t const before = test::allocations();
+            util::high_resolution_timer time;
+            std::vector<promise> promises(chains());
+            for (std::size_t i = 0; i != promises.size(); ++i)
+                attach<Step>(promises[i], &results[i]);
+            attaching += time.elapsed();
+            if (runs == 0)
+                allocations = test::allocations() - before;
+
+            time.restart();
+            for (std::size_t i = 0; i != promises.size(); ++i)
+                promises[i].set_value(static_cast<long>(i));
+            promises.clear();
+            completing += time.elapsed();
+            ++runs;
+        }
+        while (attaching + completing < 1.0);
+
+        report<Callback>(name, attaching / runs, completing / runs, allocations, results);
+    }
+};
+
+template<class Callback>
+using pending = chained<Callback, step>;
+
+template<class Callback>
+using move_only = chained<Callback, move_only_step>;
+
+// Attaches every chain to a promise fulfilled already, so that every
+// continuation runs as soon as it is attached.
+template<class Callback>
+struct ready
+{
+    static void run(char const* name)
+    {
+        typedef async::promise<long, Callback, async::single_thread> promise;
+        std::vector<long> results(chains());
+        auto const job = [&]
+        {
+            for (std::size_t i = 0; i != results.size(); ++i)
+            {
+                promise p;
+                p.set_value(static_cast<long>(i));
+                attach<step>(p, &results[i]);
+            }
+        };
+        std::size_t const before = test::allocations();
+        job();
+        std::size_t const allocations = test::allocations() - before;
+        double const elapsed = test::time_per_run(job);
+
+        report<Callback>(name, elapsed, 0, allocations, results);
+    }
+};
+
+// Another thread fulfils every promise as soon as its future is taken,
+// racing with the continuations being attached, so that the chains run on
+// either thread.
+template<class Callback>
+struct racing
+{
+    static void run(char const* name)
+    {
+        typedef async::promise<long, Callback, async::cross_thread> promise;
+        std::vector<long> results(chains());
+        // Every allocation is made on this thread.
+        auto const job = [&]
+        {
+            std::vector<promise> promises(chains());
+            std::atomic<std::size_t> published(0);
+            std::thread completer([&]
+            {
+                for (std::size_t i = 0; i != promises.size(); ++i)
+                {
+                    while (published.load(std::memory_order_acquire) <= i)
+                        std::this_thread::yield();
+                    promises[i].set_value(static_cast<long>(i));
+                }
+            });
+            for (std::size_t i = 0; i != promises.size(); ++i)
+            {
+                async::future<long, Callback, async::cross_thread> f = promises[i].get_future();
+                published.store(i + 1, std::memory_order_release);
+                for (std::size_t j = 0; j != length; ++j)
+                    f = f.then(step{static_cast<long>(j)});
+                long* result = &results[i];
+                f.finally([result](long v) { *result = v; });
+            }
+            completer.join();
+        };
+        std::size_t const before = test::allocations();
+        job();
+        std::size_t const allocations = test::allocations() - before;
+        double const elapsed = test::time_per_run(job);
+
+        report<Callback>(name, elapsed, 0, allocations, results);
+    }
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<continuation> >)
+        (Case< std::function<continuation> >)
+        (Case< cxx_function::function<continuation> >)
+        (Case< cxx_function::unique_function<continuation> >)
+        (Case< multifunction<continuation> >)
+        (Case< boost::function<continuation> >)
+        (Case< func::function<continuation> >)
+        (Case< generic::delegate<continuation> >)
+        (Case< fu2::function<continuation> >)
+        (Case< fu2::unique_function<continuation> >)
+        (Case< fixed_size_function<continuation> >)
+        (Case< gnr_forwarder<continuation> >)
+        (Case< embxx_util_StaticFunction<continuation> >)
+        (Case< Function_<continuation> >)
+        (Case< SmallFun<continuation> >)
+    )
+    std::cout << std::endl;
+}
+
+// Only the wrappers that can hold a callable that can't be copied.
+void benchmark_move_only()
+{
+    std::cout << "[move-only]\n";
+    WORKLOAD_BENCHMARK(
+        (move_only< cxx_function::unique_function<continuation> >)
+        (move_only< fu2::unique_function<continuation> >)
+        (move_only< fixed_size_function_move<continuation> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: futures [lengths...], by default 1, 10 and 100, at most
+// MAX_LENGTH.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0 || sizes.back() > MAX_LENGTH)
+        {
+            std::cerr << "futures: " << argv[i] << " is no chain length from 1 to " << MAX_LENGTH << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1, 10, 100};
+
+    for (std::size_t size : sizes)
+    {
+        length = size;
+        std::cout << "[" << length << " continuation" << (length == 1 ? "" : "s") << " per chain]\n";
+        benchmark<pending>("pending");
+        benchmark<ready>("ready");
+        benchmark<racing>("cross-thread");
+        benchmark_move_only();
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
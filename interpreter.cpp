@@ -0,0 +1,181 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include "workload.hpp"
+
+
+#define FIELDS 8
+#define RECORDS 1024
+#define DEPTH 7
+
+
+struct record
+{
+    unsigned field[FIELDS];
+};
+
+typedef unsigned expression(record const&);
+
+// Calls an operand, held by pointer or by value.
+template<class F>
+unsigned eval(F* f, record const& r)
+{
+    return (*f)(r);
+}
+
+template<class F>
+unsigned eval(F& f, record const& r)
+{
+    return f(r);
+}
+
+// Compiles a random expression over a record into a tree of closures,
+// the way a rules engine does: make(fn) turns a closure into the Node
+// its parent captures.
+template<class Node, class Make>
+Node compile(std::mt19937& gen, int depth, Make& make)
+{
+    if (depth == 0)
+    {
+        if (gen() & 1)
+        {
+            unsigned i = gen() % FIELDS;
+            return make([i](record const& r) { return r.field[i]; });
+        }
+        unsigned k = gen() % 100;
+        return make([k](record const&) { return k; });
+    }
+
+    Node lhs = compile<Node>(gen, depth - 1, make);
+    Node rhs = compile<Node>(gen, depth - 1, make);
+    switch (gen() % 8)
+    {
+    case 0:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return eval(lhs, r) + eval(rhs, r); });
+    case 1:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return eval(lhs, r) - eval(rhs, r); });
+    case 2:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return eval(lhs, r) * eval(rhs, r); });
+    case 3:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return unsigned(eval(lhs, r) < eval(rhs, r)); });
+    case 4:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return unsigned(eval(lhs, r) > eval(rhs, r)); });
+    case 5:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return unsigned(eval(lhs, r) == eval(rhs, r)); });
+    case 6:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return unsigned(eval(lhs, r) && eval(rhs, r)); });
+    default:
+        return make([lhs = std::move(lhs), rhs = std::move(rhs)](record const& r) mutable
+            { return unsigned(eval(lhs, r) || eval(rhs, r)); });
+    }
+}
+
+// Builds the rule with build(gen), counting the heap allocations it
+// takes, then evaluates it for every record of a batch.
+template<class Build>
+void interpret(char const* name, Build build)
+{
+    // seeded so that the rule holds for some of the records only
+    std::mt19937 gen(8);
+    std::vector<record> records(RECORDS);
+    for (record& r : records)
+        for (unsigned& v : r.field)
+            v = gen() % 100;
+
+    std::size_t const allocations = test::allocations();
+    auto root = build(gen);
+    std::size_t const built = test::allocations() - allocations;
+
+    unsigned checksum = 0;
+    double const elapsed = test::time_per_run([&]
+    {
+        checksum = 0;
+        for (record const& r : records)
+            checksum += eval(root, r);
+    });
+
+    test::live_code += checksum;
+    test::report_rate(name, RECORDS / elapsed, "records");
+    std::cout << "{allocations: " << built << ", checksum: "
+        << std::hex << checksum << std::dec << "}" << std::endl;
+}
+
+// Every closure captures the wrappers holding its operands, so that the
+// tree nests wrappers in wrappers and each closure holds two of them:
+// past the small buffer of most implementations, and past the capacity
+// of the fixed-size ones, which are left out.
+template<class F>
+struct by_value
+{
+    static void run(char const* name)
+    {
+        interpret(name, [](std::mt19937& gen)
+        {
+            auto make = [](auto fn) { return F(std::move(fn)); };
+            return compile<F>(gen, DEPTH, make);
+        });
+    }
+};
+
+// The closures live in one arena and refer to their operands by
+// pointer, so each one carries at most two pointers and every
+// fixed-capacity wrapper can take part.
+template<class F>
+struct by_pointer
+{
+    static void run(char const* name)
+    {
+        std::vector<F> nodes;
+        nodes.reserve((2u << DEPTH) - 1);
+        interpret(name, [&](std::mt19937& gen)
+        {
+            auto make = [&](auto fn) { nodes.emplace_back(std::move(fn)); return &nodes.back(); };
+            return compile<F*>(gen, DEPTH, make);
+        });
+    }
+};
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    std::cout << "[by value]\n";
+    WORKLOAD_BENCHMARK(
+        (by_value< stdex::function<expression> >)
+        (by_value< std::function<expression> >)
+        (by_value< cxx_function::function<expression> >)
+        (by_value< multifunction<expression> >)
+        (by_value< boost::function<expression> >)
+        (by_value< func::function<expression> >)
+        (by_value< generic::delegate<expression> >)
+        (by_value< fu2::function<expression> >)
+    )
+    std::cout << std::endl;
+
+    std::cout << "[by pointer]\n";
+    WORKLOAD_BENCHMARK(
+        (by_pointer< stdex::function<expression> >)
+        (by_pointer< std::function<expression> >)
+        (by_pointer< cxx_function::function<expression> >)
+        (by_pointer< multifunction<expression> >)
+        (by_pointer< boost::function<expression> >)
+        (by_pointer< func::function<expression> >)
+        (by_pointer< generic::delegate<expression> >)
+        (by_pointer< fu2::function<expression> >)
+        (by_pointer< fixed_size_function<expression> >)
+        (by_pointer< gnr_forwarder<expression> >)
+        (by_pointer< embxx_util_StaticFunction<expression> >)
+        (by_pointer< Function_<expression> >)
+        (by_pointer< SmallFun<expression> >)
+    )
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
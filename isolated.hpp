@@ -0,0 +1,106 @@
+#if !defined(ISOLATED_HPP)
+#define ISOLATED_HPP
+
+// Runs a job in a freshly forked child process and sends its result back
+// over a pipe, so that the heap, the page cache and whatever else the job
+// leaves behind are thrown away with the child instead of being inherited
+// by the next job.  The result is copied byte by byte, so it must be
+// trivially copyable.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace test
+{
+    namespace detail
+    {
+        inline void fail(char const* what)
+        {
+            throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+        }
+    }
+
+    template<class Job>
+    auto isolated(Job&& job) -> decltype(job())
+    {
+        typedef decltype(job()) result;
+        static_assert(std::is_trivially_copyable<result>::value,
+            "the result is sent back byte by byte");
+
+        int fds[2];
+        if (pipe(fds) == -1)
+            detail::fail("pipe");
+        // Or the child would write out what the parent buffered too.
+        std::cout.flush();
+        std::fflush(nullptr);
+
+        pid_t const pid = fork();
+        if (pid == -1)
+            detail::fail("fork");
+        if (pid == 0)
+        {
+            // Nothing may leave the child but through _exit, or it would
+            // go on running the parent's code.
+            try
+            {
+                close(fds[0]);
+                result const r = job();
+                char const* p = reinterpret_cast<char const*>(&r);
+                for (std::size_t left = sizeof r; left != 0; )
+                {
+                    ssize_t const n = write(fds[1], p, left);
+                    if (n <= 0)
+                        _exit(EXIT_FAILURE);
+                    p += n;
+                    left -= static_cast<std::size_t>(n);
+                }
+            }
+            catch (...)
+            {
+                _exit(EXIT_FAILURE);
+            }
+            // Without running the parent's destructors and atexit
+            // handlers a second time.
+            _exit(EXIT_SUCCESS);
+        }
+
+        close(fds[1]);
+        result r;
+        char* p = reinterpret_cast<char*>(&r);
+        std::size_t left = sizeof r;
+        while (left != 0)
+        {
+            ssize_t const n = read(fds[0], p, left);
+            if (n == -1 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            p += n;
+            left -= static_cast<std::size_t>(n);
+        }
+        close(fds[0]);
+
+        int status;
+        while (waitpid(pid, &status, 0) == -1)
+        {
+            if (errno != EINTR)
+                detail::fail("waitpid");
+        }
+        if (left != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+            throw std::runtime_error("the isolated measurement failed");
+        return r;
+    }
+}
+
+#endif
@@ -0,0 +1,102 @@
+#!/bin/sh
+# Builds various.cpp K times, each with its functions linked in a random
+# order and with random function and loop alignment, runs every build and
+# reports for each implementation the median of its times over the layouts
+# and their spread, so that a difference between two implementations can
+# be told apart from where the linker happened to put their code.
+#
+# The order is given to lld with --symbol-ordering-file, or to gold with
+# --section-ordering-file; with neither, only the alignment changes.
+#
+# Usage: layout.sh [K] [build directory], by default 8 and _layout.  The
+# output of every build goes to <build directory>/<k>.log.
+
+set -e
+
+K=${1:-8}
+DIR=${2:-_layout}
+SRC=$(cd "$(dirname "$0")" && pwd)
+
+mkdir -p "$DIR"
+DIR=$(cd "$DIR" && pwd)
+
+if ld.lld --version >/dev/null 2>&1; then
+    LINKER=lld
+elif ld.gold --version >/dev/null 2>&1; then
+    LINKER=gold
+else
+    LINKER=
+    echo "# neither lld nor gold: only the alignment changes"
+fi
+
+: > "$DIR/times"
+k=1
+while [ "$k" -le "$K" ]; do
+    b="$DIR/$k"
+    functions=$(shuf -n 1 -e 1 16 32 64)
+    loops=$(shuf -n 1 -e 1 16 32 64)
+    echo "# layout $k: -falign-functions=$functions -falign-loops=$loops${LINKER:+, $LINKER with a random order}"
+
+    cmake -S "$SRC" -B "$b" \
+        -DCMAKE_CXX_FLAGS="-ffunction-sections -falign-functions=$functions -falign-loops=$loops" \
+        -DCMAKE_EXE_LINKER_FLAGS= > "$b.log" 2>&1
+    cmake --build "$b" --target various >> "$b.log" 2>&1
+
+    if [ -n "$LINKER" ]; then
+        # Relinks the same object with its functions shuffled.
+        nm --defined-only "$b/CMakeFiles/various.dir/various.cpp.o" \
+            | awk '$2 ~ /^[tTwW]$/ { print $3 }' | shuf > "$b/order"
+        if [ "$LINKER" = lld ]; then
+            flags="-fuse-ld=lld -Wl,--symbol-ordering-file=$b/order -Wl,--no-warn-symbol-ordering"
+        else
+            sed 's/^/.text./' "$b/order" > "$b/sections"
+            flags="-fuse-ld=gold -Wl,--section-ordering-file=$b/sections"
+        fi
+        cmake -S "$SRC" -B "$b" -DCMAKE_EXE_LINKER_FLAGS="$flags" >> "$b.log" 2>&1
+        cmake --build "$b" --target various >> "$b.log" 2>&1
+    fi
+
+    # One "section, implementation, time" line per measurement.
+    "$b/various" | awk -F '\t' '
+        /^\[/ { section = $0; next }
+        / \[s\] / {
+            i = index($0, ": ")
+            split(substr($0, i + 2), rest, " ")
+            print section "\t" substr($0, 1, i - 1) "\t" rest[1]
+        }' >> "$DIR/times"
+    k=$((k + 1))
+done
+
+echo
+awk -F '\t' '
+    {
+        key = $1 SUBSEP $2
+        if (!(key in count)) {
+            order[++keys] = key
+            sections[key] = $1
+            names[key] = $2
+        }
+        times[key, ++count[key]] = $3
+    }
+    END {
+        for (i = 1; i <= keys; ++i) {
+            key = order[i]
+            n = count[key]
+            for (j = 1; j <= n; ++j)
+                t[j] = times[key, j]
+            for (j = 2; j <= n; ++j)
+                for (l = j; l > 1 && t[l - 1] > t[l]; --l) {
+                    x = t[l]; t[l] = t[l - 1]; t[l - 1] = x
+                }
+            median = n % 2 ? t[(n + 1) / 2] : (t[n / 2] + t[n / 2 + 1]) / 2
+            if (sections[key] != section) {
+                if (section != "")
+                    print ""
+                section = sections[key]
+                print section
+            }
+            spread = median > 0 ? (t[n] - t[1]) / median * 100 : 0
+            printf "%s: %.10f [s] {min: %.10f, max: %.10f, spread: %.1f%%}\n",
+                names[key], median, t[1], t[n], spread
+        }
+    }' "$DIR/times"
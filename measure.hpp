@@ -14,10 +14,34 @@
 #endif
 
 #include "high_resolution_timer.hpp"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <boost/preprocessor/seq/for_each.hpp>
 #include <boost/preprocessor/stringize.hpp>
+#ifdef TOPDOWN
+#include "topdown.hpp"
+#endif
+#ifdef FORK
+#include "isolated.hpp"
+#endif
+#ifdef ROUNDS
+#include <numeric>
+#include <random>
+#include <vector>
+#endif
+
+// Warmup goes on until the last WARMUP_WINDOW runs took times within
+// WARMUP_TOLERANCE of the fastest of them, or WARMUP_LIMIT runs were made.
+#if !defined(WARMUP_WINDOW)
+#define WARMUP_WINDOW 3
+#endif
+#if !defined(WARMUP_TOLERANCE)
+#define WARMUP_TOLERANCE 0.05
+#endif
+#if !defined(WARMUP_LIMIT)
+#define WARMUP_LIMIT 10
+#endif
 
 namespace test
 {
@@ -74,37 +98,156 @@ namespace test
         }
     }
 
-    // Measure the time required to hammer accumulators of the given type
+    // Whether the last WARMUP_WINDOW of the given run times, kept in a
+    // ring, are close enough to each other.
+    inline bool steady(double const (&window)[WARMUP_WINDOW], int const runs)
+    {
+        if (runs < WARMUP_WINDOW)
+            return false;
+        double const fastest = *std::min_element(window, window + WARMUP_WINDOW);
+        double const slowest = *std::max_element(window, window + WARMUP_WINDOW);
+        return slowest - fastest <= fastest * WARMUP_TOLERANCE;
+    }
+
+    // Measure the time required to hammer accumulators of the given type,
+    // after warmups runs to reach a steady state
     template <class Accumulator>
-    double measure(long const repeats)
+    double measure(long const repeats, int& warmups)
     {
-        // Hammer accumulators a couple of times to ensure the
-        // instruction cache is full of our test code, and that we don't
+        // Hammer accumulators until their times settle, to ensure the
+        // instruction cache is full of our test code, that we don't
         // measure the cost of a page fault for accessing the data page
         // containing the memory where the accumulators will be
-        // allocated
-        hammer<Accumulator>(repeats);
-        hammer<Accumulator>(repeats);
+        // allocated, and that the allocator of the implementations that
+        // use the heap has grown to what they need
+        double window[WARMUP_WINDOW];
+        warmups = 0;
+        do
+        {
+            util::high_resolution_timer time;
+            hammer<Accumulator>(repeats);
+            window[warmups++ % WARMUP_WINDOW] = time.elapsed();
+        }
+        while (warmups < WARMUP_LIMIT && !steady(window, warmups));
 
         // Now start a timer
         util::high_resolution_timer time;
         hammer<Accumulator>(repeats);   // This time, we'll measure
         return time.elapsed();          // return the elapsed time
     }
-    
+
+    // Everything report prints about an accumulator type, made in one
+    // go so that it can be made in another process.
+    struct measurement
+    {
+        double elapsed;
+        int warmups;
+        int checksum;
+#ifdef TOPDOWN
+        topdown::breakdown breakdown;
+#endif
+    };
+
     template <class Accumulator>
-    void report(char const* name, long const repeats)
+    measurement measure_all(long const repeats)
+    {
+        measurement m;
+        m.elapsed = test::measure<Accumulator>(repeats, m.warmups);
+        Accumulator acc; 
+        acc.benchmark(); 
+        m.checksum = acc.val;
+#ifdef TOPDOWN
+        // One more run, under the counters.
+        m.breakdown = test::topdown::measure([=] { hammer<Accumulator>(repeats); });
+#endif
+        return m;
+    }
+
+    template <class Accumulator>
+    measurement trial(long const repeats)
+    {
+#ifdef FORK
+        // In a child of its own, which starts from the parent's state and
+        // takes whatever it leaves behind with it.
+        return isolated([=] { return measure_all<Accumulator>(repeats); });
+#else
+        return measure_all<Accumulator>(repeats);
+#endif
+    }
+
+    // Prints a measurement, leaving the line open.
+    inline void print(char const* name, measurement const& m)
     {
         std::cout.precision(10);
         std::cout << name << ": ";
         for (int i = 0; i < (20-int(strlen(name))); ++i)
             std::cout << ' ';
-        std::cout << std::fixed << test::measure<Accumulator>(repeats) << " [s] ";
-        Accumulator acc; 
-        acc.benchmark(); 
-        std::cout << std::hex << "{checksum: " << acc.val << "}";
+        std::cout << std::fixed << m.elapsed << " [s] ";
+        std::cout << std::hex << "{checksum: " << m.checksum
+            << std::dec << ", warmup: " << m.warmups << "}";
+#ifdef TOPDOWN
+        std::cout << ' ' << m.breakdown;
+#endif
+    }
+
+    template <class Accumulator>
+    void report(char const* name, long const repeats)
+    {
+        print(name, trial<Accumulator>(repeats));
         std::cout << std::flush << std::endl;
     }
+
+#ifdef ROUNDS
+    // Measures every accumulator type once per round, in a new random
+    // order every round, so that the machine slowing down or speeding up
+    // over the run is spread over all of them rather than charged to
+    // those measured last.  Each is then reported by its median trial.
+    class rounds
+    {
+    public:
+        template <class Accumulator>
+        void add(char const* name)
+        {
+            entry const e = {name, &trial<Accumulator>, std::vector<measurement>()};
+            entries.push_back(e);
+        }
+
+        void run(int const count, long const repeats)
+        {
+            std::vector<std::size_t> order(entries.size());
+            std::iota(order.begin(), order.end(), std::size_t(0));
+            std::mt19937 random{std::random_device()()};
+            for (int round = 0; round != count; ++round)
+            {
+                std::shuffle(order.begin(), order.end(), random);
+                for (std::size_t i : order)
+                    entries[i].trials.push_back(entries[i].trial(repeats));
+            }
+
+            for (entry& e : entries)
+            {
+                std::sort(e.trials.begin(), e.trials.end(),
+                    [](measurement const& a, measurement const& b) { return a.elapsed < b.elapsed; });
+                measurement const& median = e.trials[e.trials.size() / 2];
+                double const spread = (e.trials.back().elapsed - e.trials.front().elapsed) / median.elapsed;
+                print(e.name, median);
+                std::cout.precision(1);
+                std::cout << std::dec << " {rounds: " << count << ", spread: " << spread * 100 << "%}";
+                std::cout << std::flush << std::endl;
+            }
+        }
+
+    private:
+        struct entry
+        {
+            char const* name;
+            measurement (*trial)(long);
+            std::vector<measurement> trials;
+        };
+
+        std::vector<entry> entries;
+    };
+#endif
     
     struct base
     {
@@ -120,7 +263,11 @@ namespace test
     test::report<elem>(BOOST_PP_STRINGIZE(elem), repeats);          \
     /***/
 
-#define BOOST_SPIRIT_TEST_BENCHMARK(max_repeats, FSeq)              \
+#define BOOST_SPIRIT_TEST_ADD(r, data, elem)                        \
+    trials.add<elem>(BOOST_PP_STRINGIZE(elem));                     \
+    /***/
+
+#define BOOST_SPIRIT_TEST_CALIBRATE(max_repeats, FSeq)              \
     long repeats = 100;                                             \
     double measured = 0;                                            \
     while (measured < 2.0 && repeats <= max_repeats)                \
@@ -130,8 +277,21 @@ namespace test
         BOOST_PP_SEQ_FOR_EACH(BOOST_SPIRIT_TEST_HAMMER, _, FSeq)    \
         measured = time.elapsed();                                  \
     }                                                               \
+    /***/
+
+#ifdef ROUNDS
+#define BOOST_SPIRIT_TEST_BENCHMARK(max_repeats, FSeq)              \
+    BOOST_SPIRIT_TEST_CALIBRATE(max_repeats, FSeq)                  \
+    test::rounds trials;                                            \
+    BOOST_PP_SEQ_FOR_EACH(BOOST_SPIRIT_TEST_ADD, _, FSeq)           \
+    trials.run(ROUNDS, repeats);                                    \
+    /***/
+#else
+#define BOOST_SPIRIT_TEST_BENCHMARK(max_repeats, FSeq)              \
+    BOOST_SPIRIT_TEST_CALIBRATE(max_repeats, FSeq)                  \
     BOOST_PP_SEQ_FOR_EACH(BOOST_SPIRIT_TEST_MEASURE, _, FSeq)       \
     /***/
+#endif
 }
 
 #endif
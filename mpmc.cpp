@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "mpmc_queue.hpp"
+#include "workload.hpp"
+
+
+// Tasks moved through the queue by each case, and its capacity.
+#define TASKS (1 << 20)
+#define CAPACITY 1024
+// One task out of SAMPLE carries the time it was enqueued at.
+#define SAMPLE 16
+
+
+struct worker;
+typedef void task(worker&);
+
+template<class Sig>
+using fixed_size_function_move =
+    fixed_size_function<Sig, 128, construct_type::move>;
+
+// What a consumer thread hands every task it runs.
+struct worker
+{
+    std::vector<std::uint64_t> latencies;
+    std::uint64_t sum = 0;
+    std::size_t allocations = 0;
+    bool stop = false;
+};
+
+std::size_t producers;
+std::size_t consumers;
+
+std::uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void wait(std::atomic<bool> const& go)
+{
+    while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+// Producers push TASKS tasks between them, each made of a fresh closure,
+// and consumers pop and run them until each gets a stop task, pushed once
+// all the others are.  A task the queue can't take yet is retried.
+template<class Task>
+struct pipeline
+{
+    static void push(concurrent::mpmc_queue<Task>& queue, Task t)
+    {
+        while (!queue.try_push(std::move(t)))
+            std::this_thread::yield();
+    }
+
+    static void run(char const* name)
+    {
+        concurrent::mpmc_queue<Task> queue(CAPACITY);
+        std::vector<worker> workers(consumers);
+        std::vector<std::size_t> pushed(producers);
+        std::atomic<bool> go(false);
+
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p != producers; ++p)
+        {
+            threads.emplace_back([&, p]
+            {
+                std::size_t const n = TASKS / producers;
+                wait(go);
+                std::size_t const before = test::allocations();
+                for (std::size_t i = 0; i != n; ++i)
+                {
+                    std::uint64_t const stamp = i % SAMPLE ? 0 : now();
+                    std::uint64_t const payload = i;
+                    push(queue, Task([stamp, payload](worker& w)
+                    {
+                        w.sum += payload;
+                        if (stamp)
+                            w.latencies.push_back(now() - stamp);
+                    }));
+                }
+                pushed[p] = test::allocations() - before;
+            });
+        }
+        for (worker& w : workers)
+        {
+            w.latencies.reserve(TASKS / SAMPLE + 1);
+            threads.emplace_back([&]
+            {
+                wait(go);
+                std::size_t const before = test::allocations();
+                Task t;
+                while (!w.stop)
+                {
+                    if (queue.try_pop(t))
+                        t(w);
+                    else
+                        std::this_thread::yield();
+                }
+                w.allocations = test::allocations() - before;
+            });
+        }
+
+        util::high_resolution_timer time;
+        go.store(true, std::memory_order_release);
+        for (std::size_t p = 0; p != producers; ++p)
+            threads[p].join();
+        for (std::size_t c = 0; c != consumers; ++c)
+            push(queue, Task([](worker& w) { w.stop = true; }));
+        for (std::size_t c = 0; c != consumers; ++c)
+            threads[producers + c].join();
+        double const elapsed = time.elapsed();
+
+        std::vector<std::uint64_t> latencies;
+        std::size_t allocations = 0;
+        for (std::size_t n : pushed)
+            allocations += n;
+        for (worker& w : workers)
+        {
+            latencies.insert(latencies.end(), w.latencies.begin(), w.latencies.end());
+            allocations += w.allocations;
+            test::live_code += static_cast<int>(w.sum);
+        }
+        std::size_t const tasks = TASKS / producers * producers;
+        std::vector<std::uint64_t>::iterator p99 =
+            latencies.begin() + latencies.size() * 99 / 100;
+        std::nth_element(latencies.begin(), p99, latencies.end());
+
+        test::report_rate(name, tasks / elapsed, "tasks");
+        std::cout << "{size: " << sizeof(Task)
+            << ", p99: " << std::setprecision(1) << *p99 / 1e3 << " us"
+            << ", allocations/task: " << std::setprecision(2)
+            << double(allocations) / tasks << "}" << std::endl;
+    }
+};
+
+void benchmark()
+{
+    std::cout << "[" << producers << " producer" << (producers == 1 ? "" : "s")
+        << ", " << consumers << " consumer" << (consumers == 1 ? "" : "s") << "]\n";
+    WORKLOAD_BENCHMARK(
+        (pipeline< stdex::function<task> >)
+        (pipeline< std::function<task> >)
+        (pipeline< cxx_function::function<task> >)
+        (pipeline< cxx_function::unique_function<task> >)
+        (pipeline< multifunction<task> >)
+        (pipeline< boost::function<task> >)
+        (pipeline< func::function<task> >)
+        (pipeline< generic::delegate<task> >)
+        (pipeline< fu2::function<task> >)
+        (pipeline< fu2::unique_function<task> >)
+        (pipeline< fixed_size_function<task> >)
+        (pipeline< fixed_size_function_move<task> >)
+        (pipeline< gnr_forwarder<task> >)
+        (pipeline< embxx_util_StaticFunction<task> >)
+        (pipeline< Function_<task> >)
+        (pipeline< SmallFun<task> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: mpmc [threads], by default half the hardware threads.  Runs 1
+// producer with 1..threads consumers, 1..threads producers with 1
+// consumer, and as many producers as consumers, doubling each time.
+int main(int argc, char* argv[])
+{
+    std::size_t threads = argc > 1
+        ? std::strtoul(argv[1], nullptr, 10)
+        : std::thread::hardware_concurrency() / 2;
+    threads = std::max<std::size_t>(threads, 1);
+
+    for (std::size_t n = 1; n <= threads; n *= 2)
+    {
+        producers = 1, consumers = n;
+        benchmark();
+        if (n == 1)
+            continue;
+        producers = n, consumers = 1;
+        benchmark();
+        producers = n, consumers = n;
+        benchmark();
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
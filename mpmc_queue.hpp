@@ -0,0 +1,126 @@
+#if !defined(MPMC_QUEUE_HPP)
+#define MPMC_QUEUE_HPP
+
+// A lock-free bounded multi-producer multi-consumer queue after Dmitry
+// Vyukov's, templated on the element type so that the wrappers under
+// test can be moved through it the way a thread pool moves its tasks.
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace concurrent
+{
+    template<class T>
+    class mpmc_queue
+    {
+    public:
+        // capacity must be a power of two.
+        explicit mpmc_queue(std::size_t capacity)
+          : cells(new cell[capacity]), mask(capacity - 1)
+        {
+            assert(capacity >= 2 && (capacity & mask) == 0);
+            for (std::size_t i = 0; i != capacity; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            enqueue_pos.store(0, std::memory_order_relaxed);
+            dequeue_pos.store(0, std::memory_order_relaxed);
+        }
+
+        mpmc_queue(mpmc_queue const&) = delete;
+        mpmc_queue& operator=(mpmc_queue const&) = delete;
+
+        ~mpmc_queue()
+        {
+            T v;
+            while (try_pop(v))
+                ;
+        }
+
+        // Moves v into the queue unless it is full, in which case v is
+        // left untouched.
+        bool try_push(T&& v)
+        {
+            std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell& c = cells[pos & mask];
+                std::size_t const seq = c.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t const diff =
+                    static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        ::new (&c.storage) T(std::move(v));
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Moves the oldest element into v unless the queue is empty.
+        bool try_pop(T& v)
+        {
+            std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell& c = cells[pos & mask];
+                std::size_t const seq = c.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t const diff =
+                    static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeue_pos.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        T* p = reinterpret_cast<T*>(&c.storage);
+                        v = std::move(*p);
+                        p->~T();
+                        c.sequence.store(pos + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+    private:
+        // The sequence tells whose turn it is: pos when the cell is free
+        // for the push of pos, pos + 1 once it holds that element.
+        struct cell
+        {
+            std::atomic<std::size_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        std::unique_ptr<cell[]> const cells;
+        std::size_t const mask;
+        // Kept apart so that producers and consumers don't share a line.
+        alignas(64) std::atomic<std::size_t> enqueue_pos;
+        alignas(64) std::atomic<std::size_t> dequeue_pos;
+    };
+}
+
+#endif
@@ -3,6 +3,9 @@
 #include <string>
 #include <chrono>
 #include <memory>
+#include <cstdint>
+#include <utility>
+#include <tuple>
 #include <boost/type_erasure/any.hpp>
 #include <boost/type_erasure/builtin.hpp>
 #include <boost/type_erasure/callable.hpp>
@@ -17,10 +20,17 @@
     #include "cxx_function_msvc.hpp"
 #endif
 #include "function2.hpp"
-#include "measure.hpp"  
+#include "measure.hpp"
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+    #include <variant>
+    #define STD_VARIANT
+#endif  
 
 
 #define MAX_REPEAT 100000
+#define SHOW_SIZE(name) \
+std::cout << #name << ": " << sizeof(name) << std::endl;
 
 
 template<class... Sig>
@@ -39,81 +49,375 @@ struct tag {};
 
 struct empty_base {};
 
-struct virtual_base
+// Abstract interface declaring `int operator()(tag<i>)` for every i < N.
+template<int N>
+struct virtual_interface : virtual_interface<N - 1>
+{
+    using virtual_interface<N - 1>::operator();
+    virtual int operator()(tag<N - 1>) = 0;
+};
+
+template<>
+struct virtual_interface<1>
 {
     virtual int operator()(tag<0>) = 0;
-    virtual int operator()(tag<1>) = 0;
-    virtual int operator()(tag<2>) = 0;
+};
+
+// Implements `int operator()(tag<i>)` for every i < N, returning i + 1.
+template<class Base, int N>
+struct functor : functor<Base, N - 1>
+{
+    using functor<Base, N - 1>::operator();
+
+    int operator()(tag<N - 1>)
+    {
+        return N;
+    }
 };
 
 template<class Base>
-struct functor : Base
+struct functor<Base, 1> : Base
 {
     int operator()(tag<0>)
     {
-        return 0;
+        return 1;
     }
-    
-    int operator()(tag<1>)
+};
+
+// Static dispatch through a CRTP base, straight into the functor deriving
+// from it.
+template<int N>
+struct crtp_interface
+{
+    template<int i>
+    int operator()(tag<i> t)
     {
-        return 1;
+        return static_cast<functor<crtp_interface, N>&>(*this)(t);
+    }
+};
+
+#ifdef STD_VARIANT
+// Same results as functor, but keeps count of the calls.
+template<int N>
+struct counting_functor : functor<empty_base, N>
+{
+    template<int i>
+    int operator()(tag<i> t)
+    {
+        ++calls;
+        return functor<empty_base, N>::operator()(t);
     }
-    
-    int operator()(tag<2>)
+
+    int calls = 0;
+};
+
+// A closed set of implementations dispatched with std::visit.  Instances
+// alternate between the alternatives so the active one isn't known at
+// compile time.
+template<int N>
+struct variant_dispatch
+{
+    template<class F>
+    explicit variant_dispatch(F const& f)
     {
-        return 2;
+        if (instances++ & 1)
+            v = counting_functor<N>();
+        else
+            v = f;
     }
+
+    template<int i>
+    int operator()(tag<i> t)
+    {
+        return std::visit([t](auto& g) { return g(t); }, v);
+    }
+
+    std::variant<functor<empty_base, N>, counting_functor<N> > v;
+    static int instances;
 };
 
+template<int N>
+int variant_dispatch<N>::instances = 0;
+
+#define VARIANT_DISPATCH        (with< variant_dispatch<N> >)
+#define VARIANT_DISPATCH_SIZE   SHOW_SIZE(variant_dispatch<N>);
+#else
+#define VARIANT_DISPATCH        /* nothing */
+#define VARIANT_DISPATCH_SIZE   /* nothing */
+#endif
+
+// The functor implementing a virtual interface derives from it.
 template<class F>
 struct use_base
 {
     typedef empty_base type;
 };
 
-template<>
-struct use_base<virtual_base&>
+template<class F>
+struct use_base<F&>
 {
-    typedef virtual_base type;
+    typedef F type;
 };
 
-template<class F>
-struct with : test::base
+template<class Seq>
+struct suite;
+
+// Every case for the N signatures `int(tag<0>)` ... `int(tag<N - 1>)`.
+template<int... I>
+struct suite<std::integer_sequence<int, I...> >
 {
-    with()
-      : f(h)
-    {}
-    
-    void benchmark()
+    static const int N = sizeof...(I);
+
+    typedef virtual_interface<N> virtual_base;
+    typedef crtp_interface<N> crtp_base;
+    typedef functor<empty_base, N> no_abstraction;
+
+    // A hand-written vtable: one static table of function pointers per
+    // implementation, reached through a pointer stored next to the object.
+    struct pointer_table
+    {
+        typedef std::tuple<int(*)(void*, tag<I>)...> table;
+
+        template<class T>
+        explicit pointer_table(T& obj)
+          : self(&obj), vtbl(table_for<T>())
+        {}
+
+        template<int i>
+        int operator()(tag<i> t) const
+        {
+            return std::get<i>(*vtbl)(self, t);
+        }
+
+        template<class T, int i>
+        static int call(void* self, tag<i> t)
+        {
+            return (*static_cast<T*>(self))(t);
+        }
+
+        template<class T>
+        static table const* table_for()
+        {
+            static constexpr table value{&call<T, I>...};
+            return &value;
+        }
+
+        void* self;
+        table const* vtbl;
+    };
+
+    template<class F>
+    struct with : test::base
     {
-        this->val += f(tag<0>());
-        this->val += f(tag<1>());
-        this->val += f(tag<2>());
+        with()
+          : f(h)
+        {}
+
+        void benchmark()
+        {
+            int expand[] = {(this->val += f(tag<I>()), 0)...};
+            (void)expand;
+        }
+
+        // Before f, which is made from it.
+        functor<typename use_base<F>::type, N> h;
+        F f;
+    };
+
+    // Builds a fresh F from the functor each time and calls it once so
+    // that the construction can't be thrown away.  A wrapper the
+    // optimizer can see through completely costs next to nothing here.
+    template<class F>
+    struct construct : test::base
+    {
+        void benchmark()
+        {
+            F f(h);
+            this->val += f(tag<N - 1>());
+        }
+
+        functor<typename use_base<F>::type, N> h;
+    };
+
+    static void run()
+    {
+        std::cout << std::dec << "[" << N << " signature" << (N == 1 ? "" : "s") << "]\n";
+
+        std::cout << "[size]\n";
+        SHOW_SIZE(stdex::function<int(tag<I>)...>);
+        SHOW_SIZE(multifunction<int(tag<I>)...>);
+        SHOW_SIZE(cxx_function::function<int(tag<I>)...>);
+        SHOW_SIZE(fu2::function<int(tag<I>)...>);
+        SHOW_SIZE(virtual_base*);
+        SHOW_SIZE(crtp_base*);
+        SHOW_SIZE(pointer_table);
+        VARIANT_DISPATCH_SIZE
+
+        std::cout << "[construct]\n";
+        {
+            BOOST_SPIRIT_TEST_BENCHMARK(
+                MAX_REPEAT,
+                (construct< stdex::function<int(tag<I>)...> >)
+                (construct< multifunction<int(tag<I>)...> >)
+                (construct< cxx_function::function<int(tag<I>)...> >)
+                (construct< fu2::function<int(tag<I>)...> >)
+                (construct< virtual_base& >)
+            )
+        }
+
+        std::cout << "[call]\n";
+        {
+            BOOST_SPIRIT_TEST_BENCHMARK(
+                MAX_REPEAT,
+                (with< no_abstraction >)
+                (with< stdex::function<int(tag<I>)...> >)
+                (with< multifunction<int(tag<I>)...> >)
+                (with< cxx_function::function<int(tag<I>)...> >)
+                (with< fu2::function<int(tag<I>)...> >)
+                (with< virtual_base& >)
+                (with< crtp_base& >)
+                (with< pointer_table >)
+                VARIANT_DISPATCH
+            )
+        }
+        std::cout << std::endl;
     }
-    
-    F f;
-    functor<typename use_base<F>::type> h;
 };
 
-template<class... Sig>
+// Message dispatch: signatures that differ in argument and return types,
+// so resolving the overload and forwarding the arguments aren't free.
+namespace messages
+{
+    struct header
+    {
+        std::uint32_t type;
+        std::uint32_t length;
+        std::uint64_t sequence;
+    };
+
+    struct byte_span
+    {
+        unsigned char const* data;
+        std::size_t size;
+    };
+
+    struct order
+    {
+        std::uint64_t id;
+        std::int64_t price;
+        std::int32_t quantity;
+        std::int32_t side;
+        char symbol[40];
+    };
+
+    template<template<class...> class Function>
+    using handler =
+        Function<
+            bool(header const&, byte_span),
+            std::size_t(order&&),
+            double(int, double)
+        >;
+
+    struct virtual_handler
+    {
+        virtual bool operator()(header const&, byte_span) = 0;
+        virtual std::size_t operator()(order&&) = 0;
+        virtual double operator()(int, double) = 0;
+    };
+
+    template<class Base>
+    struct functor : Base
+    {
+        bool operator()(header const& h, byte_span payload)
+        {
+            return h.length == payload.size && payload.data[0] == h.type;
+        }
+
+        std::size_t operator()(order&& o)
+        {
+            last = std::move(o);
+            return static_cast<std::size_t>(last.quantity);
+        }
+
+        double operator()(int quantity, double price)
+        {
+            return quantity * price;
+        }
+
+        order last = order();
+    };
+
+    template<class F>
+    struct dispatch : test::base
+    {
+        dispatch()
+          : f(h)
+        {
+            hdr.type = 1;
+            hdr.length = sizeof(payload);
+            hdr.sequence = 0;
+            payload[0] = 1;
+            o.id = 42;
+            o.price = 100;
+            o.quantity = 2;
+            o.side = 0;
+        }
+
+        void benchmark()
+        {
+            this->val += f(hdr, byte_span{payload, sizeof(payload)});
+            this->val += static_cast<int>(f(order(o)));
+            this->val += static_cast<int>(f(this->val & 3, 0.5));
+        }
+
+        // Before f, which is made from a copy of it.
+        functor<typename use_base<F>::type> h;
+        F f;
+        header hdr;
+        unsigned char payload[64];
+        order o;
+    };
+
+    void benchmark()
+    {
+        typedef functor<empty_base> no_abstraction;
+
+        std::cout << std::dec << "[messages]\n";
+        std::cout << "[size]\n";
+        SHOW_SIZE(handler<stdex::function>);
+        SHOW_SIZE(handler<multifunction>);
+        SHOW_SIZE(handler<cxx_function::function>);
+        SHOW_SIZE(handler<fu2::function>);
+        SHOW_SIZE(virtual_handler*);
+
+        std::cout << "[call]\n";
+        BOOST_SPIRIT_TEST_BENCHMARK(
+            MAX_REPEAT,
+            (dispatch< no_abstraction >)
+            (dispatch< handler<stdex::function> >)
+            (dispatch< handler<multifunction> >)
+            (dispatch< handler<cxx_function::function> >)
+            (dispatch< handler<fu2::function> >)
+            (dispatch< virtual_handler& >)
+        )
+        std::cout << std::endl;
+    }
+}
+
+template<int N>
 void benchmark()
 {
-    typedef functor<empty_base> no_abstraction;
-    
-    BOOST_SPIRIT_TEST_BENCHMARK(
-        MAX_REPEAT,
-        (with< no_abstraction >)
-        (with< stdex::function<Sig...> >)
-        (with< multifunction<Sig...> >)
-        (with< cxx_function::function<Sig...> >)
-        (with< fu2::function<Sig...> >)
-        (with< virtual_base& >)
-    )
+    suite<std::make_integer_sequence<int, N> >::run();
 }
 
 int main(int /*argc*/, char* /*argv*/[])
 {
-    benchmark<int(tag<0>), int(tag<1>), int(tag<2>)>();
+    benchmark<1>();
+    benchmark<2>();
+    benchmark<4>();
+    benchmark<8>();
+    benchmark<16>();
+    messages::benchmark();
 
     // This is ultimately responsible for preventing all the test code
     // from being optimized away.  Change this to return 0 and you
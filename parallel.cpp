@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "parallel_for.hpp"
+#include "workload.hpp"
+
+
+// Every loop runs over ELEMENTS indices, in chunks of GRAIN.
+#define ELEMENTS (1 << 20)
+#define GRAIN 1024
+// Steps of the heavy body per element.
+#define STEPS 64
+
+typedef void body(std::size_t, std::size_t);
+
+// Number of threads running every loop, the calling one included.
+std::size_t threads;
+
+std::vector<double> in(ELEMENTS), out(ELEMENTS);
+
+// A few operations per element: memory bound.
+struct light
+{
+    static void apply(double const* from, double* to, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i != end; ++i)
+            to[i] = from[i] * 3 + 1;
+    }
+};
+
+// A dependent chain of STEPS multiply-adds and a square root per element:
+// compute bound.
+struct heavy
+{
+    static void apply(double const* from, double* to, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i != end; ++i)
+        {
+            double x = from[i];
+            for (int s = 0; s != STEPS; ++s)
+                x = x * 0.999 + 0.5;
+            to[i] = std::sqrt(x);
+        }
+    }
+};
+
+// The body captures in and out by pointer, as a body usually captures
+// the ranges it works on.
+template<class Kernel, concurrent::sharing S>
+struct looping
+{
+    template<class F>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            double const* const from = in.data();
+            double* const to = out.data();
+            F const f([from, to](std::size_t begin, std::size_t end)
+            {
+                Kernel::apply(from, to, begin, end);
+            });
+
+            concurrent::team team(threads);
+            double const elapsed = test::time_per_run([&]
+            {
+                concurrent::parallel_for<S>(team, ELEMENTS, GRAIN, f);
+            });
+
+            double checksum = 0;
+            for (double v : out)
+                checksum += v;
+            test::live_code += static_cast<int>(checksum);
+            test::report_rate(name, ELEMENTS / elapsed, "elements");
+            std::cout << "{checksum: " << checksum << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<body> >)
+        (Case< std::function<body> >)
+        (Case< cxx_function::function<body> >)
+        (Case< multifunction<body> >)
+        (Case< boost::function<body> >)
+        (Case< func::function<body> >)
+        (Case< generic::delegate<body> >)
+        (Case< fu2::function<body> >)
+        (Case< fixed_size_function<body> >)
+        (Case< gnr_forwarder<body> >)
+        (Case< embxx_util_StaticFunction<body> >)
+        (Case< Function_<body> >)
+        (Case< SmallFun<body> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: parallel [threads], by default one per hardware thread.  Runs
+// every loop on 1, 2, 4... threads up to that many.
+int main(int argc, char* argv[])
+{
+    std::size_t most = argc > 1
+        ? std::strtoul(argv[1], nullptr, 10)
+        : std::thread::hardware_concurrency();
+    most = std::max<std::size_t>(most, 1);
+
+    for (std::size_t i = 0; i != in.size(); ++i)
+        in[i] = static_cast<double>(i % 1000);
+
+    for (threads = 1; threads <= most; threads *= 2)
+    {
+        std::cout << "[" << threads << " thread" << (threads == 1 ? "" : "s") << "]\n";
+        benchmark<looping<light, concurrent::sharing::packed>::with>("light, packed");
+        benchmark<looping<light, concurrent::sharing::padded>::with>("light, padded");
+        benchmark<looping<light, concurrent::sharing::copied>::with>("light, copied");
+        benchmark<looping<heavy, concurrent::sharing::packed>::with>("heavy, packed");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
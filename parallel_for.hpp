@@ -0,0 +1,92 @@
+#if !defined(PARALLEL_FOR_HPP)
+#define PARALLEL_FOR_HPP
+
+// A std::thread-based parallel for taking its body as a type-erased
+// callable shared by every thread, so that the wrappers under test can be
+// compared the way a parallel algorithms library stores the loop body.
+// The threads are those of a team from team.hpp, started once and reused
+// by every loop.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include "team.hpp"
+
+
+namespace concurrent
+{
+    // How the threads of a parallel_for reach its body.
+    enum class sharing
+    {
+        // The body sits right after the counter the threads grab chunks
+        // from, on the same cache line, as a plain struct would lay it out.
+        packed,
+        // The body and the counter are on cache lines of their own.
+        padded,
+        // Every chunk runs on a copy of the body, as when it is passed on
+        // by value.
+        copied
+    };
+
+    namespace detail
+    {
+        template<class Body, sharing S>
+        struct loop
+        {
+            explicit loop(Body const& b)
+              : next(0), body(b)
+            {}
+
+            std::atomic<std::size_t> next;
+            Body body;
+        };
+
+        template<class Body>
+        struct loop<Body, sharing::padded>
+        {
+            explicit loop(Body const& b)
+              : next(0), body(b)
+            {}
+
+            alignas(64) std::atomic<std::size_t> next;
+            alignas(64) Body body;
+        };
+    }
+
+    // Calls body(begin, end) over chunks of grain indices of [0, n), which
+    // the threads of the team grab in turn.  The body is copied once into
+    // the loop's shared state, and once per chunk with sharing::copied.
+    // It is called through a non-const path, as not every wrapper offers
+    // a const one, but must not change.
+    template<sharing S = sharing::packed, class Body>
+    void parallel_for(team& threads, std::size_t n, std::size_t grain, Body const& body)
+    {
+        detail::loop<Body, S> shared(body);
+        auto const work = [&shared, n, grain](std::size_t)
+        {
+            for (;;)
+            {
+                std::size_t const begin = shared.next.fetch_add(grain, std::memory_order_relaxed);
+                if (begin >= n)
+                    return;
+                std::size_t const end = std::min(begin + grain, n);
+                if (S == sharing::copied)
+                {
+                    // From a const lvalue, which is what every copy
+                    // constructor takes over a forwarding one.
+                    Body local(static_cast<Body const&>(shared.body));
+                    local(begin, end);
+                }
+                else
+                {
+                    shared.body(begin, end);
+                }
+            }
+        };
+
+        threads.run(work);
+    }
+}
+
+#endif
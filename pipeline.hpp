@@ -0,0 +1,69 @@
+#if !defined(PIPELINE_HPP)
+#define PIPELINE_HPP
+
+// A push-based stream pipeline, templated on the wrapper holding every
+// stage, so that the implementations under test can be compared the way
+// streaming analytics chain them.  A stage takes an event by reference,
+// may change it, and returns whether it goes on to the next stage: maps,
+// filters, windows and reductions all fit.
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace stream
+{
+    template<class T, class Stage>
+    class pipeline
+    {
+    public:
+        // Appends fn, held in a Stage, to the end of the pipeline.
+        template<class Fn>
+        pipeline& then(Fn fn)
+        {
+            stages.push_back(Stage(std::move(fn)));
+            return *this;
+        }
+
+        // Runs the event through the stages, one after the other, until
+        // one stops it.
+        void push(T v)
+        {
+            for (Stage& s : stages)
+            {
+                if (!s(v))
+                    return;
+            }
+        }
+
+        // Runs every event of the batch through a stage before the next
+        // one, keeping in place those that go on.  Every stage sees the
+        // events in the same order as if they were pushed one by one.
+        void push(T* batch, std::size_t n)
+        {
+            for (Stage& s : stages)
+            {
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i != n; ++i)
+                {
+                    if (s(batch[i]))
+                        batch[kept++] = batch[i];
+                }
+                n = kept;
+                if (n == 0)
+                    return;
+            }
+        }
+
+        std::size_t size() const
+        {
+            return stages.size();
+        }
+
+    private:
+        std::vector<Stage> stages;
+    };
+}
+
+#endif
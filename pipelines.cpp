@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "pipeline.hpp"
+#include "workload.hpp"
+
+
+// Events pushed by each timed run, and the size of a batch.
+#define EVENTS 10000000
+#define BATCH 256
+// Events a window stage sums over.
+#define WINDOW 4
+
+typedef bool stage(std::int64_t&);
+
+// Number of stages of every pipeline, the reduction at the end included.
+std::size_t stages;
+
+// The last events seen by a window stage.
+struct window
+{
+    std::int64_t values[WINDOW];
+    std::int64_t sum;
+    std::size_t next;
+};
+
+// What the stateful stages of a pipeline keep between events.
+struct state
+{
+    explicit state(std::size_t windows)
+      : windows(windows)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (window& w : windows)
+            w = window{};
+        total = 0;
+    }
+
+    std::vector<window> windows;
+    std::int64_t total;
+};
+
+// Cycles through map, filter, sliding window and another map, then ends
+// with a reduction; every stage is a different callable type.
+template<class Pipeline>
+void build(Pipeline& p, state* s)
+{
+    for (std::size_t i = 0; i + 1 < stages; ++i)
+    {
+        std::int64_t const k = static_cast<std::int64_t>(i) * 2 + 1;
+        switch (i % 4)
+        {
+        case 0:
+            p.then([k](std::int64_t& v) { v = v * 5 + k; return true; });
+            break;
+        case 1:
+            p.then([k](std::int64_t& v) { return ((v ^ k) & 15) != 0; });
+            break;
+        case 2:
+        {
+            window* w = &s->windows[i / 4];
+            p.then([w](std::int64_t& v)
+            {
+                w->sum += v - w->values[w->next];
+                w->values[w->next] = v;
+                w->next = (w->next + 1) % WINDOW;
+                v = w->sum;
+                return true;
+            });
+            break;
+        }
+        default:
+            p.then([k](std::int64_t& v) { v = (v >> 3) ^ (v * k); return true; });
+            break;
+        }
+    }
+    p.then([s](std::int64_t& v) { s->total += v; return false; });
+}
+
+template<bool Batched>
+struct feeding
+{
+    template<class Stage>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            state s(stages / 4 + 1);
+            stream::pipeline<std::int64_t, Stage> p;
+            build(p, &s);
+
+            std::int64_t batch[BATCH];
+            double const elapsed = test::time_per_run([&]
+            {
+                s.reset();
+                if (Batched)
+                {
+                    for (std::size_t i = 0; i < EVENTS; i += BATCH)
+                    {
+                        std::size_t const n = std::min<std::size_t>(BATCH, EVENTS - i);
+                        for (std::size_t j = 0; j != n; ++j)
+                            batch[j] = static_cast<std::int64_t>(i + j);
+                        p.push(batch, n);
+                    }
+                }
+                else
+                {
+                    for (std::size_t i = 0; i != EVENTS; ++i)
+                        p.push(static_cast<std::int64_t>(i));
+                }
+            });
+
+            test::live_code += static_cast<int>(s.total);
+            test::report_rate(name, EVENTS / elapsed, "events");
+            std::cout << "{ns/stage: " << std::setprecision(2) << elapsed / EVENTS / stages * 1e9
+                << ", checksum: " << std::hex << static_cast<std::uint64_t>(s.total) << std::dec
+                << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<stage> >)
+        (Case< std::function<stage> >)
+        (Case< cxx_function::function<stage> >)
+        (Case< cxx_function::unique_function<stage> >)
+        (Case< multifunction<stage> >)
+        (Case< boost::function<stage> >)
+        (Case< func::function<stage> >)
+        (Case< generic::delegate<stage> >)
+        (Case< fu2::function<stage> >)
+        (Case< fu2::unique_function<stage> >)
+        (Case< fixed_size_function<stage> >)
+        (Case< gnr_forwarder<stage> >)
+        (Case< embxx_util_StaticFunction<stage> >)
+        (Case< Function_<stage> >)
+        (Case< SmallFun<stage> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: pipelines [stages...], by default 2, 4, 8 and 16.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = {2, 4, 8, 16};
+
+    for (std::size_t size : sizes)
+    {
+        stages = std::max<std::size_t>(size, 1);
+        std::cout << "[" << stages << " stage" << (stages == 1 ? "" : "s") << "]\n";
+        benchmark<feeding<false>::with>("one by one");
+        benchmark<feeding<true>::with>("batches of " BOOST_PP_STRINGIZE(BATCH));
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,144 @@
+#if !defined(SIGNAL_HPP)
+#define SIGNAL_HPP
+
+// A minimal signal/slot container, templated on the wrapper holding each
+// slot so that the implementations under test can be compared doing
+// fan-out.  Slots may connect and disconnect, themselves or others, while
+// the signal is being emitted.
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace fanout
+{
+    // Identifies a connected slot; handed out in increasing order.
+    typedef std::size_t connection;
+
+    template<class Slot>
+    class signal
+    {
+    public:
+        signal() = default;
+        signal(signal const&) = delete;
+        signal& operator=(signal const&) = delete;
+
+        // Connects fn, held in a Slot.  A slot connected while the signal
+        // is being emitted is first called by the next emission.
+        template<class Fn>
+        connection connect(Fn fn)
+        {
+            std::vector<entry>& to = emitting ? pending : slots;
+            to.push_back(entry{next++, Slot(std::move(fn)), true});
+            return to.back().id;
+        }
+
+        // Disconnects c, if still connected.  During an emission the slot
+        // is only marked and gets erased once the emission is over, so the
+        // slots are never moved while one of them is running.
+        void disconnect(connection c)
+        {
+            std::vector<entry>& from =
+                pending.empty() || c < pending.front().id ? slots : pending;
+            typename std::vector<entry>::iterator it = find(from, c);
+            if (it == from.end() || !it->connected)
+                return;
+
+            if (emitting)
+            {
+                it->connected = false;
+                dirty = true;
+            }
+            else
+            {
+                from.erase(it);
+            }
+        }
+
+        // Calls every slot connected when the emission starts, unless it
+        // got disconnected in the meantime.
+        template<class... Args>
+        void operator()(Args const&... args)
+        {
+            emission guard(*this);
+            std::size_t const n = slots.size();
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                if (slots[i].connected)
+                    slots[i].slot(args...);
+            }
+        }
+
+        std::size_t size() const
+        {
+            return slots.size() + pending.size();
+        }
+
+        void reserve(std::size_t n)
+        {
+            slots.reserve(n);
+        }
+
+    private:
+        struct entry
+        {
+            connection id;
+            Slot slot;
+            bool connected;
+        };
+
+        // Applies the changes held back by the outermost emission, even
+        // if a slot throws.
+        struct emission
+        {
+            explicit emission(signal& s)
+              : self(s)
+            {
+                ++self.emitting;
+            }
+
+            ~emission()
+            {
+                if (--self.emitting == 0)
+                    self.flush();
+            }
+
+            signal& self;
+        };
+
+        // Slots stay sorted by id, as they are only ever appended.
+        static typename std::vector<entry>::iterator
+        find(std::vector<entry>& v, connection c)
+        {
+            typename std::vector<entry>::iterator it = std::lower_bound(
+                v.begin(), v.end(), c,
+                [](entry const& e, connection id) { return e.id < id; });
+            return it != v.end() && it->id == c ? it : v.end();
+        }
+
+        void flush()
+        {
+            if (dirty)
+            {
+                slots.erase(std::remove_if(slots.begin(), slots.end(),
+                    [](entry const& e) { return !e.connected; }), slots.end());
+                pending.erase(std::remove_if(pending.begin(), pending.end(),
+                    [](entry const& e) { return !e.connected; }), pending.end());
+                dirty = false;
+            }
+            for (entry& e : pending)
+                slots.push_back(std::move(e));
+            pending.clear();
+        }
+
+        std::vector<entry> slots;
+        std::vector<entry> pending;
+        connection next = 0;
+        int emitting = 0;
+        bool dirty = false;
+    };
+}
+
+#endif
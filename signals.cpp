@@ -0,0 +1,200 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "signal.hpp"
+#include "workload.hpp"
+
+
+// Slot calls made by each timed run, spread over as many emissions as the
+// number of connected slots allows.
+#define CALLS 100000
+
+typedef void notify(int);
+
+// Number of slots connected to the signal by each case.
+std::size_t connected;
+
+std::size_t emits_per_run()
+{
+    return connected < CALLS ? CALLS / connected : 1;
+}
+
+// Adds the value emitted to a total.  When given its connection, it also
+// disconnects itself and connects a copy while being emitted.
+template<class Slot>
+struct subscriber
+{
+    void operator()(int x) const
+    {
+        *total += x;
+        if (id)
+        {
+            sig->disconnect(*id);
+            *id = sig->connect(*this);
+        }
+    }
+
+    long* total;
+    fanout::signal<Slot>* sig;
+    fanout::connection* id;
+};
+
+// Heap bytes taken by the signal per connected slot, the slot array
+// included.
+template<class Slot>
+struct memory
+{
+    static void run(char const* name)
+    {
+        long total = 0;
+        std::size_t const before = test::allocated_bytes();
+        {
+            fanout::signal<Slot> sig;
+            sig.reserve(connected);
+            for (std::size_t i = 0; i != connected; ++i)
+                sig.connect(subscriber<Slot>{&total, nullptr, nullptr});
+        }
+        std::size_t const bytes = test::allocated_bytes() - before;
+
+        test::report_name(name);
+        std::cout << std::fixed << double(bytes) / connected
+            << " [bytes/slot] {sizeof: " << sizeof(Slot) << "}" << std::endl;
+    }
+};
+
+template<class Slot>
+struct emit
+{
+    static void run(char const* name)
+    {
+        long total = 0;
+        fanout::signal<Slot> sig;
+        for (std::size_t i = 0; i != connected; ++i)
+            sig.connect(subscriber<Slot>{&total, nullptr, nullptr});
+
+        std::size_t const emits = emits_per_run();
+        int x = 0;
+        double const elapsed = test::time_per_run([&]
+        {
+            for (std::size_t i = 0; i != emits; ++i)
+                sig(++x & 7);
+        });
+
+        test::live_code += static_cast<int>(total);
+        test::report_rate(name, emits / elapsed, "emits");
+        std::cout << std::endl;
+    }
+};
+
+// Connects a new slot and disconnects the oldest one, keeping the number
+// of connected slots steady.
+template<class Slot>
+struct churn
+{
+    static void run(char const* name)
+    {
+        long total = 0;
+        fanout::signal<Slot> sig;
+        std::vector<fanout::connection> ids(connected);
+        for (fanout::connection& id : ids)
+            id = sig.connect(subscriber<Slot>{&total, nullptr, nullptr});
+
+        std::size_t oldest = 0;
+        double const elapsed = test::time_per_run([&]
+        {
+            for (int i = 0; i != CALLS / 10; ++i)
+            {
+                fanout::connection const id =
+                    sig.connect(subscriber<Slot>{&total, nullptr, nullptr});
+                sig.disconnect(ids[oldest]);
+                ids[oldest] = id;
+                oldest = (oldest + 1) % connected;
+            }
+        });
+
+        test::live_code += static_cast<int>(sig.size());
+        test::report_rate(name, CALLS / 10 / elapsed, "pairs");
+        std::cout << std::endl;
+    }
+};
+
+// Every slot disconnects itself and connects a copy while the signal is
+// being emitted.
+template<class Slot>
+struct reentrant
+{
+    static void run(char const* name)
+    {
+        long total = 0;
+        fanout::signal<Slot> sig;
+        std::vector<fanout::connection> ids(connected);
+        for (fanout::connection& id : ids)
+            id = sig.connect(subscriber<Slot>{&total, &sig, &id});
+
+        std::size_t const emits = emits_per_run();
+        int x = 0;
+        double const elapsed = test::time_per_run([&]
+        {
+            for (std::size_t i = 0; i != emits; ++i)
+                sig(++x & 7);
+        });
+
+        test::live_code += static_cast<int>(total + sig.size());
+        test::report_rate(name, emits / elapsed, "emits");
+        std::cout << std::endl;
+    }
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< stdex::function<notify> >)
+        (Case< std::function<notify> >)
+        (Case< cxx_function::function<notify> >)
+        (Case< multifunction<notify> >)
+        (Case< boost::function<notify> >)
+        (Case< func::function<notify> >)
+        (Case< generic::delegate<notify> >)
+        (Case< fu2::function<notify> >)
+        (Case< fixed_size_function<notify> >)
+        (Case< gnr_forwarder<notify> >)
+        (Case< embxx_util_StaticFunction<notify> >)
+        (Case< Function_<notify> >)
+        (Case< SmallFun<notify> >)
+    )
+}
+
+// Usage: signals [slots...], by default 1, 10, 100 and 1000.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "signals: " << argv[i] << " is no number of slots\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1, 10, 100, 1000};
+
+    for (std::size_t size : sizes)
+    {
+        connected = size;
+        std::cout << "[" << connected << " slots]\n";
+        benchmark<memory>("memory");
+        benchmark<emit>("emit");
+        benchmark<churn>("churn");
+        benchmark<reentrant>("reentrant emit");
+        std::cout << std::endl;
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+#include "workload.hpp"
+
+
+struct record
+{
+    std::uint64_t key;
+    char payload[56];
+};
+
+// The comparator every implementation holds; used as is it can be
+// inlined into the algorithm.
+struct no_abstraction
+{
+    bool operator()(int const& a, int const& b) const
+    {
+        return a < b;
+    }
+
+    bool operator()(record const& a, record const& b) const
+    {
+        return a.key < b.key;
+    }
+};
+
+typedef bool compare_ints(int const&, int const&);
+typedef bool compare_records(record const&, record const&);
+
+// Number of elements sorted or pushed by each case.
+std::size_t elements;
+
+template<class T>
+T make_element(std::mt19937& gen);
+
+template<>
+int make_element<int>(std::mt19937& gen)
+{
+    return static_cast<int>(gen());
+}
+
+template<>
+record make_element<record>(std::mt19937& gen)
+{
+    record r = {gen(), {}};
+    return r;
+}
+
+template<class T>
+std::vector<T> make_input()
+{
+    std::mt19937 gen(42);
+    std::vector<T> input(elements);
+    for (T& e : input)
+        e = make_element<T>(gen);
+    return input;
+}
+
+template<class T>
+std::uint64_t key_of(T const& e)
+{
+    return static_cast<std::uint64_t>(e);
+}
+
+std::uint64_t key_of(record const& r)
+{
+    return r.key;
+}
+
+// Times job on a fresh copy of the input until a second has been spent
+// in it, and reports elements per second along with the allocations
+// made by one run.
+template<class T, class Job>
+void measure(char const* name, Job job)
+{
+    std::vector<T> const input = make_input<T>();
+    std::vector<T> data;
+    std::size_t allocations = 0;
+    std::uint64_t checksum = 0;
+    double elapsed = 0;
+    long runs = 0;
+    do
+    {
+        data = input;
+        std::size_t const before = test::allocations();
+        util::high_resolution_timer time;
+        checksum = job(data);
+        elapsed += time.elapsed();
+        allocations = test::allocations() - before;
+        ++runs;
+    }
+    while (elapsed < 1.0);
+
+    test::live_code += static_cast<int>(checksum);
+    test::report_rate(name, double(elements) * runs / elapsed, "elements");
+    std::cout << "{allocations: " << allocations << ", checksum: "
+        << std::hex << checksum << std::dec << "}" << std::endl;
+}
+
+// std::sort with the comparator passed by value, as it's usually done
+// with a stored one.
+template<class T>
+struct sorting
+{
+    template<class F>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            F const f(no_abstraction{});
+            measure<T>(name, [&](std::vector<T>& data)
+            {
+                std::sort(data.begin(), data.end(), f);
+                return key_of(data[data.size() / 2]);
+            });
+        }
+    };
+};
+
+// Pushes every element into a binary heap holding the comparator, then
+// pops them all.
+template<class T>
+struct heap
+{
+    template<class F>
+    struct with
+    {
+        static void run(char const* name)
+        {
+            F const f(no_abstraction{});
+            measure<T>(name, [&](std::vector<T>& data)
+            {
+                std::priority_queue<T, std::vector<T>, F> queue(f);
+                for (T const& e : data)
+                    queue.push(e);
+                std::uint64_t checksum = 0;
+                while (!queue.empty())
+                {
+                    checksum = checksum * 31 + key_of(queue.top());
+                    queue.pop();
+                }
+                return checksum;
+            });
+        }
+    };
+};
+
+template<template<class> class Case, class Sig>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << " " << elements << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< no_abstraction >)
+        (Case< stdex::function<Sig> >)
+        (Case< std::function<Sig> >)
+        (Case< cxx_function::function<Sig> >)
+        (Case< multifunction<Sig> >)
+        (Case< boost::function<Sig> >)
+        (Case< func::function<Sig> >)
+        (Case< generic::delegate<Sig> >)
+        (Case< fu2::function<Sig> >)
+        (Case< fixed_size_function<Sig> >)
+        (Case< gnr_forwarder<Sig> >)
+        (Case< embxx_util_StaticFunction<Sig> >)
+        (Case< Function_<Sig> >)
+        (Case< SmallFun<Sig> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: sort [elements...], by default 1M and 10M.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "sort: " << argv[i] << " is no number of elements\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1000000, 10000000};
+
+    for (std::size_t size : sizes)
+    {
+        elements = size;
+        benchmark<sorting<int>::with, compare_ints>("sort int");
+        benchmark<sorting<record>::with, compare_records>("sort record");
+        benchmark<heap<int>::with, compare_ints>("heap int");
+        benchmark<heap<record>::with, compare_records>("heap record");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
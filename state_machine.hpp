@@ -0,0 +1,71 @@
+#if !defined(STATE_MACHINE_HPP)
+#define STATE_MACHINE_HPP
+
+// A table-driven finite state machine, templated on the wrapper holding
+// the action of every transition, so that the implementations under test
+// can be compared the way a protocol parser uses them.
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+
+namespace fsm
+{
+    // STATES x INPUTS transitions, each to the state given and calling its
+    // action with the input taken.  Every transition starts out staying in
+    // its state with an empty action, which must not be taken.
+    template<class Action, std::size_t STATES, std::size_t INPUTS>
+    class state_machine
+    {
+    public:
+        state_machine()
+          : current(0)
+        {
+            for (std::size_t s = 0; s != STATES; ++s)
+            {
+                for (std::size_t i = 0; i != INPUTS; ++i)
+                    table[s][i].next = s;
+            }
+        }
+
+        state_machine(state_machine const&) = delete;
+        state_machine& operator=(state_machine const&) = delete;
+
+        template<class Fn>
+        void on(std::size_t state, std::size_t input, std::size_t next, Fn fn)
+        {
+            assert(state < STATES && input < INPUTS && next < STATES);
+            table[state][input].next = next;
+            table[state][input].action = Action(std::move(fn));
+        }
+
+        // Takes the transition for input and returns the new state.  The
+        // action sees the machine in the state it leaves.
+        std::size_t step(std::size_t input)
+        {
+            assert(input < INPUTS);
+            transition& t = table[current][input];
+            t.action(input);
+            current = t.next;
+            return current;
+        }
+
+        std::size_t state() const
+        {
+            return current;
+        }
+
+    private:
+        struct transition
+        {
+            std::size_t next;
+            Action action;
+        };
+
+        transition table[STATES][INPUTS];
+        std::size_t current;
+    };
+}
+
+#endif
@@ -12,6 +12,10 @@
 #include <type_traits>
 #include <typeinfo>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 // std::is_trivially_move_constructible is not well supported, so I resort to
 // Boost here :/
 #include <boost/type_traits/has_trivial_move_constructor.hpp>
@@ -56,21 +60,24 @@ namespace stdex
 
 namespace stdex { namespace detail
 {
-    template<class R, class... Ts>
-    R bad_call(std::uintptr_t /*data*/, void*, Ts... /*args*/)
-    {
-        throw std::bad_function_call();
-    }
-    
     enum class ctrl_code
     {
         del, copy, move, get
     };
     
-    inline bool null_ctrl(std::uintptr_t* /*data*/, std::uintptr_t* /*dst*/, ctrl_code /*code*/)
+    struct null_manager
     {
-        return false;
-    }
+        static bool ctrl(std::uintptr_t* /*data*/, std::uintptr_t* /*dst*/, ctrl_code /*code*/)
+        {
+            return false;
+        }
+        
+        template<class R, class... Ts>
+        static R fwd(std::uintptr_t /*data*/, void*, Ts... /*args*/)
+        {
+            throw std::bad_function_call();
+        }
+    };
     
     template<class T>
     struct is_emplaceable
@@ -84,9 +91,9 @@ namespace stdex { namespace detail
     struct function_manager
     {
         struct wrapper
-          : Alloc::template rebind<wrapper>::other, F
+          : std::allocator_traits<Alloc>::template rebind_alloc<wrapper>, F
         {
-            typedef typename Alloc::template rebind<wrapper>::other alloc_base;
+            typedef typename std::allocator_traits<Alloc>::template rebind_alloc<wrapper> alloc_base;
             using F::operator();
             
             wrapper(alloc_base&& alloc, F&& f)
@@ -116,7 +123,7 @@ namespace stdex { namespace detail
                 {
                     typename wrapper::alloc_base a(*data);
                     *dst = reinterpret_cast<std::uintptr_t>(new(a.allocate(1))
-                        wrapper(std::move(a), F(static_cast<F&&>(*data))));
+                        wrapper(std::move(a), F(static_cast<F const&>(*data))));
                     break;
                 }
             case ctrl_code::move:
@@ -211,17 +218,118 @@ namespace stdex { namespace detail
         }
     };
     
-    template<class F>
-    struct trampoline
+    // The table shared by every function holding the same callable type:
+    // the manager's ctrl followed by one forwarder per signature.  Each
+    // signature derives from the table of the ones after it, so the table
+    // of a signature list also serves every tail of that list.
+    template<class... Sig>
+    struct vtable;
+    
+    template<class... T>
+    struct type_list {};
+    
+    // The table of the tail of a signature list starting at S.
+    template<class S, class List>
+    struct tail_from;
+    
+    template<class S, class... Rest>
+    struct tail_from<S, type_list<S, Rest...> >
     {
-        trampoline() {}
-
-        trampoline(F* f)
-          : f(f)
+        typedef vtable<S, Rest...> type;
+    };
+    
+    template<class S, class T, class... Rest>
+    struct tail_from<S, type_list<T, Rest...> >
+      : tail_from<S, type_list<Rest...> >
+    {};
+    
+    struct pick {};
+    
+    template<>
+    struct vtable<>
+    {
+        template<class Manager>
+        constexpr explicit vtable(Manager)
+          : ctrl(&Manager::ctrl)
+        {}
+        
+        template<class... Sig>
+        vtable(pick, vtable<Sig...> const& src)
+          : ctrl(src.ctrl)
         {}
+        
+        bool (*ctrl)(std::uintptr_t*, std::uintptr_t*, ctrl_code);
+    };
     
-        F* f;
+    template<class R, class... Ts, class... Rest>
+    struct vtable<R(Ts...), Rest...> : vtable<Rest...>
+    {
+        template<class Manager>
+        constexpr explicit vtable(Manager m)
+          : vtable<Rest...>(m), fwd(&Manager::template fwd<R, Ts...>)
+        {}
+        
+        // the entries of src for these signatures, which it has in any
+        // order
+        template<class... Sig>
+        vtable(pick p, vtable<Sig...> const& src)
+          : vtable<Rest...>(p, src),
+            fwd(static_cast<typename tail_from<R(Ts...), type_list<Sig...> >::type const&>(src).fwd)
+        {}
+        
+        R (*fwd)(std::uintptr_t, void*, Ts...);
+    };
+    
+    template<class Manager, class... Sig>
+    struct vtable_for
+    {
+        static const vtable<Sig...> value;
     };
+    
+    template<class Manager, class... Sig>
+    const vtable<Sig...> vtable_for<Manager, Sig...>::value{Manager()};
+    
+    template<class T, class... Ts>
+    struct is_one_of
+      : std::integral_constant<bool, false>
+    {};
+    
+    template<class T, class U, class... Us>
+    struct is_one_of<T, U, Us...>
+      : std::integral_constant<bool, std::is_same<T, U>::value
+            || is_one_of<T, Us...>::value>
+    {};
+    
+    template<class Tail, class List>
+    struct is_tail_of
+      : std::is_same<Tail, List>
+    {};
+    
+    template<class Tail, class T, class... Ts>
+    struct is_tail_of<Tail, type_list<T, Ts...> >
+      : std::integral_constant<bool, std::is_same<Tail, type_list<T, Ts...> >::value
+            || is_tail_of<Tail, type_list<Ts...> >::value>
+    {};
+    
+    // The table of Table's signatures picked from src, whose signatures
+    // include them but not as a tail.  Made the first time a function of
+    // src's callable type is copied or moved into one of Table's
+    // signatures and kept until the program ends: that first time takes
+    // the heap, and every copy or move takes a lock.
+    template<class Table, class... Sig>
+    Table const* picked(vtable<Sig...> const* src)
+    {
+        static std::mutex m;
+        static std::map<vtable<Sig...> const*, Table> tables;
+        std::lock_guard<std::mutex> lock(m);
+        typename std::map<vtable<Sig...> const*, Table>::iterator it = tables.find(src);
+        if (it == tables.end())
+        {
+            it = tables.emplace(std::piecewise_construct,
+                std::forward_as_tuple(src), std::forward_as_tuple(pick(), *src)).first;
+        }
+        return &it->second;
+    }
 }}
 
 namespace stdex
@@ -241,69 +349,63 @@ namespace stdex
           : std::integral_constant<bool, true>
         {};
         
-        explicit function(internal_tag) {}
-        
-        template<class F, class Alloc>
-        function(internal_tag, F& f, Alloc const& alloc)
-          : _ctrl(detail::function_manager<F, Alloc>::ctrl)
-        {
-            detail::function_manager<F, Alloc>::create(&_data, f, alloc);
-        }
+        explicit function(internal_tag) noexcept
+          : _vtbl(table<detail::null_manager>())
+        {}
         
-        template<class... Sig>
-        function(internal_tag, function<Sig...>& other, bool& moved)
-          : _ctrl(other._ctrl)
+        template<class Manager>
+        static detail::vtable<> const* table() noexcept
         {
-            moved = _ctrl(&other._data, &_data, detail::ctrl_code::move);
+            return &detail::vtable_for<Manager>::value;
         }
         
     public:
         
         function() noexcept
-          : _ctrl(detail::null_ctrl)
+          : _vtbl(table<detail::null_manager>())
         {}
     
         function(std::nullptr_t) noexcept
-          : _ctrl(detail::null_ctrl)
+          : _vtbl(table<detail::null_manager>())
         {}
     
         template<class F, class Alloc = std::allocator<void> >
         function(F f, Alloc const& alloc = Alloc())
-          : _ctrl(detail::function_manager<F, Alloc>::ctrl)
+          : _vtbl(table<detail::null_manager>())
         {
-            detail::function_manager<F, Alloc>::create(&_data, f, alloc);
+            init(table<detail::function_manager<F, Alloc> >(), f, alloc);
         }
         
         template<class R2, class... T2s>
         function(R2(*p)(T2s...)) noexcept
+          : _vtbl(table<detail::null_manager>())
         {
             if (p)
                 init_raw(p);
-            else
-                init_null();
         }
     
         // copy
         function(function const& other)
-          : _ctrl(other._ctrl)
+          : _vtbl(table<detail::null_manager>())
         {
-            _ctrl(&other._data, &_data, detail::ctrl_code::copy);
+            init_copy(other);
         }
     
         // copy from superset
         template<class... Sig>
         function(function<Sig...> const& other)
-          : _ctrl(other._ctrl)
+          : _vtbl(table<detail::null_manager>())
         {
-            _ctrl(&other._data, &_data, detail::ctrl_code::copy);
+            init_copy(other);
         }
         
-        // move / move from superset
+        // move / move from superset; not noexcept when the table has to
+        // be picked, which may take the heap and takes a lock
         template<class... Sig>
         function(function<Sig...>&& other) noexcept
-          : _ctrl(other._ctrl)
+          : _vtbl(table<detail::null_manager>())
         {
-            if (_ctrl(&other._data, &_data, detail::ctrl_code::move))
+            if (init_move(other))
                 other.init_null();
         }
         
@@ -316,27 +418,27 @@ namespace stdex
         void swap(function& other) noexcept
         {
             std::uintptr_t tmp;
-            _ctrl(&_data, &tmp, detail::ctrl_code::move);
-            other._ctrl(&other._data, &_data, detail::ctrl_code::move);
-            _ctrl(&tmp, &other._data, detail::ctrl_code::move);
-            std::swap(_ctrl, other._ctrl);
+            _vtbl->ctrl(&_data, &tmp, detail::ctrl_code::move);
+            other._vtbl->ctrl(&other._data, &_data, detail::ctrl_code::move);
+            _vtbl->ctrl(&tmp, &other._data, detail::ctrl_code::move);
+            std::swap(_vtbl, other._vtbl);
         }
                 
         ~function()
         {
-            _ctrl(&_data, nullptr, detail::ctrl_code::del);
+            _vtbl->ctrl(&_data, nullptr, detail::ctrl_code::del);
         }
         
         explicit operator bool() const noexcept
         {
-            return _ctrl != detail::null_ctrl;
+            return _vtbl->ctrl != detail::null_manager::ctrl;
         }
 
         std::type_info const& target_type() const
         {
             std::uintptr_t ret[2] =
                 {reinterpret_cast<std::uintptr_t>(&typeid(void))};
-            _ctrl(&_data, ret, detail::ctrl_code::get);
+            _vtbl->ctrl(&_data, ret, detail::ctrl_code::get);
             return *reinterpret_cast<std::type_info const*>(ret[0]);
         }
         
@@ -345,7 +447,7 @@ namespace stdex
         {
             std::uintptr_t ret[2] =
                 {reinterpret_cast<std::uintptr_t>(&typeid(void))};
-            _ctrl(&_data, ret, detail::ctrl_code::get);
+            _vtbl->ctrl(&_data, ret, detail::ctrl_code::get);
             if (*reinterpret_cast<std::type_info const*>(ret[0]) == typeid(T))
                 return reinterpret_cast<T*>(ret[1]);
             else
@@ -364,34 +466,49 @@ namespace stdex
     
     protected:
     
+        // vtbl must be the table of the manager for F
+        template<class F, class Alloc>
+        void init(detail::vtable<> const* vtbl, F& f, Alloc const& alloc)
+        {
+            detail::function_manager<F, Alloc>::create(&_data, f, alloc);
+            _vtbl = vtbl;
+        }
+        
         template<class F>
         void init_raw(F f)
         {
-            _ctrl = detail::function_manager<F>::ctrl;
-            detail::function_manager<F>::create(&_data, f);
+            init(table<detail::function_manager<F> >(), f, std::allocator<void>());
         }
         
         void init_null()
         {
-            _ctrl = detail::null_ctrl;
+            _vtbl = table<detail::null_manager>();
         }
         
-        void steal(function& other)
+        // other's table must also serve *this
+        void init_copy(function const& other)
         {
-            swap(other);
+            other._vtbl->ctrl(&other._data, &_data, detail::ctrl_code::copy);
+            _vtbl = other._vtbl;
         }
         
-        bool (*_ctrl)(std::uintptr_t*, std::uintptr_t*, detail::ctrl_code);
-        mutable std::uintptr_t _data; // may store small object inplace
+        // returns whether other has to be nulled
+        bool init_move(function& other) noexcept
+        {
+            _vtbl = other._vtbl;
+            return _vtbl->ctrl(&other._data, &_data, detail::ctrl_code::move);
+        }
+        
+        detail::vtable<> const* _vtbl; // shared by all holding the same type
+        mutable std::uintptr_t _data = 0; // may store small object inplace
     };
 
     template<class R, class... Ts, class... Rest>
     class function<R(Ts...), Rest...>
       : function<Rest...> // avoid slicing
-      , public detail::trampoline<R(std::uintptr_t, void*, Ts...)>
     {
         typedef function<Rest...> base_type;
-        typedef detail::trampoline<R(std::uintptr_t, void*, Ts...)> caller;
+        typedef detail::vtable<R(Ts...), Rest...> vtable_type;
         
     protected:
 
@@ -399,40 +516,56 @@ namespace stdex
         
         template<class T>
         struct is_subset_of
-          : std::integral_constant<bool, std::is_base_of<caller, T>::value
-             && base_type::template is_subset_of<T>::value>
+          : std::integral_constant<bool, false>
         {};
         
-        explicit function(internal_tag tag)
-          : base_type(tag)
-        {}
+        template<class... Sig>
+        struct is_subset_of<function<Sig...> >
+          : std::integral_constant<bool, detail::is_one_of<R(Ts...), Sig...>::value
+             && base_type::template is_subset_of<function<Sig...> >::value>
+        {};
+        
+        // whether the table of T also serves *this
+        template<class T>
+        struct shares_vtable;
         
-        template<class F, class Alloc>
-        function(internal_tag tag, F& f, Alloc const& alloc)
-          : base_type(tag, f, alloc)
-          , caller(detail::function_manager<F, Alloc>::template fwd<R, Ts...>)
-        {}
-    
         template<class... Sig>
-        function(internal_tag tag, function<Sig...>& other, bool& moved)
-          : base_type(tag, other, moved), caller(other)
+        struct shares_vtable<function<Sig...> >
+          : detail::is_tail_of<detail::type_list<R(Ts...), Rest...>,
+                detail::type_list<Sig...> >
+        {};
+        
+        explicit function(internal_tag tag) noexcept
+          : base_type(tag)
         {}
+        
+        template<class Manager>
+        static detail::vtable<> const* table() noexcept
+        {
+            return &detail::vtable_for<Manager, R(Ts...), Rest...>::value;
+        }
     
     public:
         
         function() noexcept
-          : caller(detail::bad_call<R, Ts...>)
-        {}
+          : base_type(internal_tag())
+        {
+            init_null();
+        }
     
         function(std::nullptr_t) noexcept
-          : caller(detail::bad_call<R, Ts...>)
-        {}
+          : base_type(internal_tag())
+        {
+            init_null();
+        }
         
         template<class F, class Alloc = std::allocator<void> >
         function(F f, Alloc const& alloc = Alloc())
-          : base_type(internal_tag(), f, alloc)
-          , caller(detail::function_manager<F, Alloc>::template fwd<R, Ts...>)
-        {}
+          : base_type(internal_tag())
+        {
+            init_null();
+            this->init(table<detail::function_manager<F, Alloc> >(), f, alloc);
+        }
         
         template<class R2, class... T2s>
         function(R2(*p)(T2s...)) noexcept
@@ -446,42 +579,49 @@ namespace stdex
 
         // copy
         function(function const& other)
-          : base_type(static_cast<base_type const&>(other)), caller(other)
-        {}
+          : base_type(internal_tag())
+        {
+            this->init_copy(other);
+        }
 
-        // copy from superset
+        // copy from superset; in place and sharing other's table when
+        // these signatures are the last ones of other's, in place with a
+        // table picked from other's otherwise (see detail::picked), and
+        // either way target() finds the callable other holds
         template<class... Sig>
         function(function<Sig...> const& other, typename std::enable_if<
             is_subset_of<function<Sig...> >::value>::type* = 0)
-          : base_type(other), caller(other)
-        {}
+          : base_type(internal_tag())
+        {
+            copy_from(other, shares_vtable<function<Sig...> >());
+        }
         
-        // move / move from superset
+        // move / move from superset; not noexcept when the table has to
+        // be picked, which may take the heap and takes a lock
         template<class... Sig>
-        function(function<Sig...>&& other, typename std::enable_if<is_subset_of<
-            function<Sig...> >::value, bool>::type moved = false) noexcept
-          : base_type(internal_tag(), other, moved), caller(other)
+        function(function<Sig...>&& other, typename std::enable_if<
+            is_subset_of<function<Sig...> >::value>::type* = 0)
+            noexcept(shares_vtable<function<Sig...> >::value)
+          : base_type(internal_tag())
         {
-            if (moved)
-                other.init_null();
+            move_from(other, shares_vtable<function<Sig...> >());
         }
 
         function& operator=(function other) noexcept
         {
-            steal(other);
+            swap(other);
             return *this;
         }
         
         void swap(function& other) noexcept
         {
             base_type::swap(other);
-            std::swap(caller::f, other.caller::f);
         }
     
         R operator()(Ts... args) const
         {
-            return
-                caller::f(this->_data, &this->_data, std::forward<Ts>(args)...);
+            return static_cast<vtable_type const*>(this->_vtbl)->fwd(
+                this->_data, &this->_data, std::forward<Ts>(args)...);
         }
             
         using base_type::operator();
@@ -497,20 +637,56 @@ namespace stdex
         template<class F>
         void init_raw(F f)
         {
-            caller::f = detail::function_manager<F>::template fwd<R, Ts...>;
-            base_type::init_raw(f);
+            this->init(table<detail::function_manager<F> >(), f,
+                std::allocator<void>());
         }
         
         void init_null()
         {
-            caller::f = detail::bad_call<R, Ts...>;
-            base_type::init_null();
+            this->_vtbl = table<detail::null_manager>();
+        }
+        
+        template<class... Sig>
+        void copy_from(function<Sig...> const& other, std::true_type)
+        {
+            this->init_copy(other);
+        }
+        
+        // the signatures of other are laid out differently, so the table
+        // is one picked from other's, and the callable is copied in place
+        // as with a shared table
+        template<class... Sig>
+        void copy_from(function<Sig...> const& other, std::false_type)
+        {
+            init_null();
+            if (other)
+            {
+                detail::vtable<> const* vtbl = detail::picked<vtable_type>(
+                    static_cast<detail::vtable<Sig...> const*>(other._vtbl));
+                other._vtbl->ctrl(&other._data, &this->_data, detail::ctrl_code::copy);
+                this->_vtbl = vtbl;
+            }
+        }
+        
+        template<class... Sig>
+        void move_from(function<Sig...>& other, std::true_type) noexcept
+        {
+            if (this->init_move(other))
+                other.init_null();
         }
         
-        void steal(function& other) noexcept
+        template<class... Sig>
+        void move_from(function<Sig...>& other, std::false_type)
         {
-            base_type::steal(other);
-            caller::f = other.caller::f;
+            init_null();
+            if (other)
+            {
+                detail::vtable<> const* vtbl = detail::picked<vtable_type>(
+                    static_cast<detail::vtable<Sig...> const*>(other._vtbl));
+                if (other._vtbl->ctrl(&other._data, &this->_data, detail::ctrl_code::move))
+                    other.init_null();
+                this->_vtbl = vtbl;
+            }
         }
     };
     
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include "atomic_function.hpp"
+#include "team.hpp"
+#include "workload.hpp"
+
+
+// Calls made by every reader of each timed run.
+#define CALLS 1000000
+
+typedef long handler(long);
+
+#if __cplusplus >= 201703L
+typedef std::shared_mutex shared_mutex;
+#else
+typedef std::shared_timed_mutex shared_mutex;
+#endif
+
+// Number of threads calling the callback.
+std::size_t readers;
+
+template<class F>
+using atomic = concurrent::atomic_function<F>;
+
+// The usual way to swap a callback under readers: a std::function behind
+// a reader-writer lock, with the same interface as atomic_function.
+template<class F>
+class locked
+{
+public:
+    typedef F function_type;
+
+    class reader
+    {
+    public:
+        explicit reader(locked& l)
+          : l(l)
+        {}
+
+        long operator()(long x)
+        {
+            std::shared_lock<shared_mutex> lock(l.m);
+            return l.fn(x);
+        }
+
+    private:
+        locked& l;
+    };
+
+    // Any number of readers.
+    locked(F f, std::size_t)
+      : fn(std::move(f))
+    {}
+
+    void store(F f)
+    {
+        std::unique_lock<shared_mutex> lock(m);
+        fn = std::move(f);
+    }
+
+private:
+    shared_mutex m;
+    F fn;
+};
+
+// A strategy and the one it is swapped for, of different types.
+template<class F>
+F strategy(long n)
+{
+    if (n % 2 == 0)
+        return F([n](long x) { return x * 3 + n; });
+    return F([n](long x) { return (x ^ n) - 1; });
+}
+
+// The readers call the callback while a writer swaps it for another every
+// Micros microseconds, or never with 0.
+template<unsigned Micros>
+struct swapping
+{
+    template<class Slot>
+    struct with
+    {
+        typedef typename Slot::function_type F;
+
+        static void run(char const* name)
+        {
+            Slot slot(strategy<F>(0), readers);
+            std::atomic<long> sum(0), swaps(0);
+            std::atomic<std::size_t> done(0);
+
+            // Thread 0 swaps, the others read.
+            concurrent::team team(readers + 1);
+            double const elapsed = test::timed_per_run([&]
+            {
+                done.store(0, std::memory_order_relaxed);
+                swaps.store(0, std::memory_order_relaxed);
+                return team.run([&](std::size_t t)
+                {
+                    if (t != 0)
+                    {
+                        typename Slot::reader call(slot);
+                        long local = 0;
+                        for (long i = 0; i != CALLS; ++i)
+                            local += call(i);
+                        sum += local;
+                        done.fetch_add(1, std::memory_order_release);
+                    }
+                    else if (Micros != 0)
+                    {
+                        while (done.load(std::memory_order_acquire) != readers)
+                        {
+                            std::this_thread::sleep_for(std::chrono::microseconds(Micros));
+                            slot.store(strategy<F>(swaps.fetch_add(1, std::memory_order_relaxed) + 1));
+                        }
+                    }
+                });
+            });
+
+            test::live_code += static_cast<int>(sum.load());
+            test::report_rate(name, readers * CALLS / elapsed, "calls");
+            std::cout << "{ns/call: " << std::setprecision(2) << elapsed / CALLS * 1e9
+                << ", swaps/s: " << static_cast<long>(swaps.load() / elapsed)
+                << "}" << std::endl;
+        }
+    };
+};
+
+template<template<class> class Case>
+void benchmark(char const* name)
+{
+    std::cout << "[" << name << "]\n";
+    WORKLOAD_BENCHMARK(
+        (Case< locked<std::function<handler>> >)
+        (Case< atomic<stdex::function<handler>> >)
+        (Case< atomic<std::function<handler>> >)
+        (Case< atomic<cxx_function::function<handler>> >)
+        (Case< atomic<cxx_function::unique_function<handler>> >)
+        (Case< atomic<multifunction<handler>> >)
+        (Case< atomic<boost::function<handler>> >)
+        (Case< atomic<func::function<handler>> >)
+        (Case< atomic<generic::delegate<handler>> >)
+        (Case< atomic<fu2::function<handler>> >)
+        (Case< atomic<fu2::unique_function<handler>> >)
+        (Case< atomic<fixed_size_function<handler>> >)
+        (Case< atomic<gnr_forwarder<handler>> >)
+        (Case< atomic<embxx_util_StaticFunction<handler>> >)
+        (Case< atomic<Function_<handler>> >)
+        (Case< atomic<SmallFun<handler>> >)
+    )
+    std::cout << std::endl;
+}
+
+// Usage: swaps [readers], by default one per hardware thread.  Runs every
+// case with 1, 2, 4... readers up to that many.
+int main(int argc, char* argv[])
+{
+    std::size_t most = argc > 1
+        ? std::strtoul(argv[1], nullptr, 10)
+        : std::thread::hardware_concurrency();
+    most = std::max<std::size_t>(most, 1);
+
+    for (readers = 1; readers <= most; readers *= 2)
+    {
+        std::cout << "[" << readers << " reader" << (readers == 1 ? "" : "s") << "]\n";
+        benchmark<swapping<0>::with>("no swaps");
+        benchmark<swapping<1000>::with>("swap every 1 ms");
+        benchmark<swapping<10>::with>("swap every 10 us");
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,120 @@
+#if !defined(TEAM_HPP)
+#define TEAM_HPP
+
+// Threads started once and reused by every run of a multi-threaded
+// benchmark, as a library's pool would be, so that a run does not pay for
+// starting and joining them.  In between runs they sleep; a run starts
+// once every thread has reached a barrier, and is timed from there.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "high_resolution_timer.hpp"
+
+
+namespace concurrent
+{
+    // Threads, the calling one included, that run the same job together
+    // and wait for the next one in between.
+    class team
+    {
+    public:
+        explicit team(std::size_t threads)
+          : job(nullptr), context(nullptr), generation(0), stopping(false),
+            arrived(0), running(0)
+        {
+            for (std::size_t t = 1; t < threads; ++t)
+                others.emplace_back([this, t] { serve(t); });
+        }
+
+        team(team const&) = delete;
+        team& operator=(team const&) = delete;
+
+        ~team()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m);
+                stopping = true;
+            }
+            started.notify_all();
+            for (std::thread& t : others)
+                t.join();
+        }
+
+        std::size_t size() const
+        {
+            return others.size() + 1;
+        }
+
+        // Calls work(t) on every thread t, 0 being the calling one, once
+        // they have all reached the barrier, and returns the seconds from
+        // then until the last of them is done.
+        template<class Work>
+        double run(Work const& work)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m);
+                job = [](void const* w, std::size_t t) { (*static_cast<Work const*>(w))(t); };
+                context = &work;
+                arrived.store(0, std::memory_order_relaxed);
+                running.store(others.size(), std::memory_order_relaxed);
+                ++generation;
+            }
+            started.notify_all();
+
+            arrive();
+            util::high_resolution_timer time;
+            work(0);
+            while (running.load(std::memory_order_acquire) != 0)
+                std::this_thread::yield();
+            return time.elapsed();
+        }
+
+    private:
+        // Waits for every thread to get there, yielding rather than
+        // spinning so that more threads than cores still get there.
+        void arrive()
+        {
+            arrived.fetch_add(1, std::memory_order_acq_rel);
+            while (arrived.load(std::memory_order_acquire) != size())
+                std::this_thread::yield();
+        }
+
+        void serve(std::size_t t)
+        {
+            std::size_t seen = 0;
+            for (;;)
+            {
+                void (*f)(void const*, std::size_t);
+                void const* w;
+                {
+                    std::unique_lock<std::mutex> lock(m);
+                    started.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+                    seen = generation;
+                    f = job;
+                    w = context;
+                }
+
+                arrive();
+                f(w, t);
+                running.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        void (*job)(void const*, std::size_t);
+        void const* context;
+        std::size_t generation;
+        bool stopping;
+        std::mutex m;
+        std::condition_variable started;
+        std::atomic<std::size_t> arrived, running;
+        std::vector<std::thread> others;
+    };
+}
+
+#endif
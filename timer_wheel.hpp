@@ -0,0 +1,225 @@
+#if !defined(TIMER_WHEEL_HPP)
+#define TIMER_WHEEL_HPP
+
+// A hierarchical timing wheel templated on the wrapper holding each
+// callback, so that the implementations under test can be compared as
+// the pending timeouts of a network stack: millions of them, most
+// cancelled before they fire.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace timing
+{
+    // Identifies a scheduled timer.  Cancelling one that has already
+    // fired or been cancelled does nothing, even once its node is reused.
+    struct timer_handle
+    {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    // LEVELS wheels of 256 slots each: level l holds the timers due in
+    // less than 256^(l + 1) ticks, in the slot given by their expiration
+    // tick, and is cascaded into the lower levels as time reaches it.
+    // Timers live in chunks of nodes that never move, linked into their
+    // slot by index.
+    template<class Callback>
+    class timer_wheel
+    {
+    public:
+        static const int LEVELS = 4;
+        static const int SLOT_BITS = 8;
+        static const std::uint32_t SLOTS = 1u << SLOT_BITS;
+
+        timer_wheel()
+          : current(0), pending(0), free(nil)
+        {
+            for (std::uint32_t& head : heads)
+                head = nil;
+        }
+
+        timer_wheel(timer_wheel const&) = delete;
+        timer_wheel& operator=(timer_wheel const&) = delete;
+
+        ~timer_wheel()
+        {
+            for (std::uint32_t& head : heads)
+            {
+                while (head != nil)
+                    release(unlink(head));
+            }
+        }
+
+        // Calls fn, held in a Callback, once delay ticks have passed.
+        // delay must be less than 256^LEVELS.
+        template<class Fn>
+        timer_handle schedule(std::uint64_t delay, Fn fn)
+        {
+            assert(delay < (std::uint64_t(1) << (SLOT_BITS * LEVELS)));
+            std::uint32_t const i = allocate();
+            node& n = at(i);
+            ::new (&n.callback) Callback(std::move(fn));
+            n.expires = current + (delay ? delay : 1);
+            insert(i);
+            ++pending;
+            return timer_handle{i, n.generation};
+        }
+
+        // Returns whether the timer was still pending.
+        bool cancel(timer_handle h)
+        {
+            if (h.index >= chunks.size() * CHUNK)
+                return false;
+            node& n = at(h.index);
+            if (n.generation != h.generation || n.slot == nil)
+                return false;
+            release(unlink(h.index));
+            --pending;
+            return true;
+        }
+
+        // Moves time forward, calling every timer that comes due, and
+        // returns how many did.  A callback may schedule and cancel
+        // timers, itself included.
+        std::size_t advance(std::uint64_t ticks)
+        {
+            std::size_t fired = 0;
+            while (ticks--)
+            {
+                ++current;
+                cascade(1);
+                std::uint32_t& head = heads[current & (SLOTS - 1)];
+                while (head != nil)
+                {
+                    std::uint32_t const i = unlink(head);
+                    --pending;
+                    Callback& callback = *reinterpret_cast<Callback*>(&at(i).callback);
+                    callback();
+                    release(i);
+                    ++fired;
+                }
+            }
+            return fired;
+        }
+
+        std::uint64_t now() const
+        {
+            return current;
+        }
+
+        std::size_t size() const
+        {
+            return pending;
+        }
+
+    private:
+        static const std::uint32_t nil = ~std::uint32_t(0);
+        static const std::uint32_t CHUNK = 4096;
+
+        struct node
+        {
+            typename std::aligned_storage<sizeof(Callback), alignof(Callback)>::type callback;
+            std::uint64_t expires;
+            // Neighbours in the slot list; next links the free list too.
+            std::uint32_t prev;
+            std::uint32_t next;
+            std::uint32_t generation;
+            // Index of the slot list holding the node, nil when not pending.
+            std::uint32_t slot;
+        };
+
+        node& at(std::uint32_t i)
+        {
+            return chunks[i / CHUNK][i % CHUNK];
+        }
+
+        std::uint32_t allocate()
+        {
+            if (free == nil)
+            {
+                std::uint32_t const first = static_cast<std::uint32_t>(chunks.size() * CHUNK);
+                chunks.emplace_back(new node[CHUNK]);
+                for (std::uint32_t i = CHUNK; i--; )
+                {
+                    node& n = chunks.back()[i];
+                    n.generation = 0;
+                    n.slot = nil;
+                    n.next = free;
+                    free = first + i;
+                }
+            }
+            std::uint32_t const i = free;
+            free = at(i).next;
+            return i;
+        }
+
+        // Destroys the callback and puts the node back on the free list.
+        void release(std::uint32_t i)
+        {
+            node& n = at(i);
+            reinterpret_cast<Callback*>(&n.callback)->~Callback();
+            ++n.generation;
+            n.next = free;
+            free = i;
+        }
+
+        void insert(std::uint32_t i)
+        {
+            node& n = at(i);
+            std::uint64_t const delta = n.expires - current;
+            int level = 0;
+            while (level + 1 < LEVELS && delta >> (SLOT_BITS * (level + 1)))
+                ++level;
+            n.slot = level * SLOTS +
+                static_cast<std::uint32_t>((n.expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+            n.prev = nil;
+            n.next = heads[n.slot];
+            if (n.next != nil)
+                at(n.next).prev = i;
+            heads[n.slot] = i;
+        }
+
+        // Takes the node out of its slot list and returns it.
+        std::uint32_t unlink(std::uint32_t i)
+        {
+            node& n = at(i);
+            if (n.prev != nil)
+                at(n.prev).next = n.next;
+            else
+                heads[n.slot] = n.next;
+            if (n.next != nil)
+                at(n.next).prev = n.prev;
+            n.slot = nil;
+            return i;
+        }
+
+        // Once the levels below have wrapped around, spreads the slot of
+        // level that is now due over the lower levels.
+        void cascade(int level)
+        {
+            if (level == LEVELS || (current >> (SLOT_BITS * level) << (SLOT_BITS * level)) != current)
+                return;
+            cascade(level + 1);
+            std::uint32_t& head = heads[level * SLOTS +
+                ((current >> (SLOT_BITS * level)) & (SLOTS - 1))];
+            while (head != nil)
+                insert(unlink(head));
+        }
+
+        std::vector<std::unique_ptr<node[]> > chunks;
+        std::uint32_t heads[LEVELS * SLOTS];
+        std::uint64_t current;
+        std::size_t pending;
+        std::uint32_t free;
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "timer_wheel.hpp"
+#include "workload.hpp"
+
+
+// Timers are due within 1 to MAX_DELAY ticks.
+#define MAX_DELAY (1 << 20)
+
+typedef void timeout();
+
+// Number of pending timers scheduled by each case.
+std::size_t timers;
+
+// Schedules every timer, cancels them all in random order, then schedules
+// them again and lets them all expire, until a second has been spent.
+// Reports the rate of each phase and the heap bytes per pending timer the
+// first time they are all scheduled.
+template<class Callback>
+struct wheel
+{
+    static void run(char const* name)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<std::uint32_t> delay(1, MAX_DELAY - 1);
+        std::vector<std::uint32_t> delays(timers);
+        for (std::uint32_t& d : delays)
+            d = delay(gen);
+        std::vector<std::size_t> order(timers);
+        for (std::size_t i = 0; i != order.size(); ++i)
+            order[i] = i;
+        std::shuffle(order.begin(), order.end(), gen);
+
+        timing::timer_wheel<Callback> wheel;
+        std::vector<timing::timer_handle> handles(timers);
+        std::uint64_t fired = 0;
+        auto const schedule_all = [&]
+        {
+            for (std::size_t i = 0; i != timers; ++i)
+            {
+                std::uint64_t* counter = &fired;
+                std::uint64_t const id = i;
+                handles[i] = wheel.schedule(delays[i], [counter, id] { *counter += id; });
+            }
+        };
+
+        std::size_t bytes = 0;
+        double scheduling = 0, cancelling = 0, expiring = 0;
+        long cycles = 0;
+        do
+        {
+            std::size_t const before = test::allocated_bytes();
+            util::high_resolution_timer time;
+            schedule_all();
+            scheduling += time.elapsed();
+            if (cycles == 0)
+                bytes = test::allocated_bytes() - before;
+
+            time.restart();
+            for (std::size_t i : order)
+                wheel.cancel(handles[i]);
+            cancelling += time.elapsed();
+
+            schedule_all();
+            fired = 0;
+            time.restart();
+            wheel.advance(MAX_DELAY);
+            expiring += time.elapsed();
+            ++cycles;
+        }
+        while (scheduling + cancelling + expiring < 1.0);
+
+        test::live_code += static_cast<int>(fired);
+        double const n = double(timers) * cycles;
+        test::report_rate(name, n / scheduling, "schedules");
+        std::cout << n / cancelling / 1e6 << " [Mcancels/s] "
+            << n / expiring / 1e6 << " [Mexpiries/s] "
+            << "{bytes/timer: " << std::setprecision(1) << double(bytes) / timers
+            << ", checksum: " << std::hex << fired << std::dec << "}" << std::endl;
+    }
+};
+
+// Usage: timers [timers...], by default 1M and 10M.
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        if (sizes.back() == 0)
+        {
+            std::cerr << "timers: " << argv[i] << " is no number of timers\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1000000, 10000000};
+
+    for (std::size_t size : sizes)
+    {
+        timers = size;
+        std::cout << "[" << timers << " timers]\n";
+        WORKLOAD_BENCHMARK(
+            (wheel< stdex::function<timeout> >)
+            (wheel< std::function<timeout> >)
+            (wheel< cxx_function::function<timeout> >)
+            (wheel< cxx_function::unique_function<timeout> >)
+            (wheel< multifunction<timeout> >)
+            (wheel< boost::function<timeout> >)
+            (wheel< func::function<timeout> >)
+            (wheel< generic::delegate<timeout> >)
+            (wheel< fu2::function<timeout> >)
+            (wheel< fu2::unique_function<timeout> >)
+            (wheel< fixed_size_function<timeout> >)
+            (wheel< gnr_forwarder<timeout> >)
+            (wheel< embxx_util_StaticFunction<timeout> >)
+            (wheel< Function_<timeout> >)
+            (wheel< SmallFun<timeout> >)
+        )
+        std::cout << std::endl;
+    }
+
+    // This is ultimately responsible for preventing all the test code
+    // from being optimized away.  Change this to return 0 and you
+    // unplug the whole test's life support system.
+    return test::live_code != 0;
+}
@@ -0,0 +1,377 @@
+#if !defined(TOPDOWN_HPP)
+#define TOPDOWN_HPP
+
+// A top-down breakdown of where the pipeline slots of a measurement go,
+// read from perf_event_open counter groups: level 1 splits the slots into
+// frontend bound, bad speculation, backend bound and retiring; level 2
+// adds the branch mispredictions, instruction cache and iTLB misses behind
+// the first two, per thousand instructions.  The level 1 events are the
+// ones the kernel publishes under /sys/bus/event_source/devices/cpu, so
+// the breakdown is unsupported wherever it publishes none, and says why.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace test
+{
+    namespace topdown
+    {
+        struct breakdown
+        {
+            // Why there is no breakdown, or empty.  Held in place, so that
+            // a breakdown can be copied from another process.
+            char unsupported[96];
+            // Level 1, as fractions of the slots.
+            double frontend, bad_speculation, backend, retiring;
+            // Level 2, per thousand instructions, negative where the
+            // event is missing.
+            double mispredicts, icache_misses, itlb_misses;
+        };
+
+        inline breakdown none(char const* why)
+        {
+            breakdown b = {{0}, 0, 0, 0, 0, -1, -1, -1};
+            std::strncpy(b.unsupported, why, sizeof b.unsupported - 1);
+            return b;
+        }
+
+        inline std::ostream& operator<<(std::ostream& os, breakdown const& b)
+        {
+            if (b.unsupported[0])
+                return os << "{topdown: unsupported, " << b.unsupported << "}";
+
+            char const* bound = "frontend";
+            double most = b.frontend;
+            if (b.bad_speculation > most)
+            {
+                bound = "bad speculation";
+                most = b.bad_speculation;
+            }
+            if (b.backend > most)
+                bound = "backend";
+
+            std::streamsize const precision = os.precision(1);
+            std::ios_base::fmtflags const flags = os.setf(std::ios_base::fixed, std::ios_base::floatfield);
+            os << "{frontend: " << b.frontend * 100
+               << "%, bad speculation: " << b.bad_speculation * 100
+               << "%, backend: " << b.backend * 100
+               << "%, retiring: " << b.retiring * 100
+               << "%, bound: " << bound;
+            os.precision(2);
+            if (b.mispredicts >= 0)
+                os << ", mispredicts/ki: " << b.mispredicts;
+            if (b.icache_misses >= 0)
+                os << ", icache misses/ki: " << b.icache_misses;
+            if (b.itlb_misses >= 0)
+                os << ", itlb misses/ki: " << b.itlb_misses;
+            os.precision(precision);
+            os.flags(flags);
+            return os << "}";
+        }
+
+#if defined(__linux__)
+        namespace detail
+        {
+            inline bool read_file(std::string const& path, std::string& s)
+            {
+                std::ifstream in(path.c_str());
+                return static_cast<bool>(std::getline(in, s));
+            }
+
+            // An event as the kernel describes it in sysfs, such as
+            // "event=0xd,umask=0x3,cmask=1", turned into a raw config by
+            // the bit ranges listed under format/.
+            struct sysfs_event
+            {
+                bool found;
+                std::uint32_t type;
+                std::uint64_t config;
+                double scale;
+            };
+
+            inline sysfs_event find(std::string const& pmu, char const* name)
+            {
+                sysfs_event e = {false, 0, 0, 1.0};
+                std::string const dir = "/sys/bus/event_source/devices/" + pmu + "/";
+                std::string s;
+                if (!read_file(dir + "type", s))
+                    return e;
+                e.type = static_cast<std::uint32_t>(std::stoul(s));
+                if (!read_file(dir + "events/" + name, s))
+                    return e;
+
+                std::stringstream terms(s);
+                std::string term;
+                while (std::getline(terms, term, ','))
+                {
+                    std::string::size_type const eq = term.find('=');
+                    std::string const field = term.substr(0, eq);
+                    std::uint64_t const value = eq == std::string::npos
+                        ? 1 : std::stoull(term.substr(eq + 1), nullptr, 0);
+
+                    // "config:8-15" or "config:18".
+                    std::string format;
+                    if (!read_file(dir + "format/" + field, format) || format.compare(0, 7, "config:") != 0)
+                        return e;
+                    unsigned const low = std::stoul(format.substr(7));
+                    e.config |= value << low;
+                }
+                if (read_file(dir + "events/" + name + ".scale", s))
+                    e.scale = std::stod(s);
+                e.found = true;
+                return e;
+            }
+
+            inline int open(std::uint32_t type, std::uint64_t config, int group)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof attr);
+                attr.size = sizeof attr;
+                attr.type = type;
+                attr.config = config;
+                attr.disabled = group == -1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP
+                    | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+            }
+
+            inline std::uint64_t cache(std::uint64_t id)
+            {
+                return id | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            }
+
+            // Counters opened as one group, which the kernel schedules
+            // together; a group it had to multiplex is scaled up.
+            class group
+            {
+            public:
+                group()
+                  : error(0)
+                {}
+
+                group(group const&) = delete;
+                group& operator=(group const&) = delete;
+
+                ~group()
+                {
+                    for (int fd : fds)
+                        close(fd);
+                }
+
+                // Whether the event is counted, as the leader if it is the
+                // first one.
+                bool add(std::uint32_t type, std::uint64_t config)
+                {
+                    int const fd = open(type, config, fds.empty() ? -1 : fds.front());
+                    if (fd == -1)
+                    {
+                        error = errno;
+                        return false;
+                    }
+                    fds.push_back(fd);
+                    return true;
+                }
+
+                void start()
+                {
+                    ioctl(fds.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                    ioctl(fds.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+                }
+
+                // The counts in the order they were added.
+                std::vector<double> stop()
+                {
+                    ioctl(fds.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+                    std::vector<std::uint64_t> values(3 + fds.size());
+                    std::vector<double> counts(fds.size());
+                    ssize_t const size = static_cast<ssize_t>(values.size() * sizeof(std::uint64_t));
+                    if (read(fds.front(), values.data(), size) != size || values[2] == 0)
+                        return counts;
+                    double const scale = double(values[1]) / double(values[2]);
+                    for (std::size_t i = 0; i != counts.size(); ++i)
+                        counts[i] = double(values[3 + i]) * scale;
+                    return counts;
+                }
+
+                bool empty() const
+                {
+                    return fds.empty();
+                }
+
+                int error;
+
+            private:
+                std::vector<int> fds;
+            };
+        }
+
+        // Counts the level 1 and level 2 events around a job.  Either the
+        // events of Ice Lake and later, where the kernel derives the four
+        // level 1 counts from the slots, or those of the earlier cores,
+        // from which the level 1 fractions are computed as perf stat
+        // --topdown does.
+        class counters
+        {
+        public:
+            counters()
+              : unsupported(0), metrics(false),
+                has_mispredicts(false), has_icache(false), has_itlb(false)
+            {
+                char const* const recent[] = {
+                    "slots", "topdown-fe-bound", "topdown-bad-spec", "topdown-be-bound", "topdown-retiring"};
+                char const* const earlier[] = {
+                    "topdown-total-slots", "topdown-fetch-bubbles", "topdown-slots-issued",
+                    "topdown-slots-retired", "topdown-recovery-bubbles"};
+
+                char const* const pmus[] = {"cpu", "cpu_core"};
+                for (char const* pmu : pmus)
+                {
+                    if (find_all(pmu, recent))
+                    {
+                        metrics = true;
+                        break;
+                    }
+                    if (find_all(pmu, earlier))
+                        break;
+                }
+                if (events.empty())
+                {
+                    unsupported = "the CPU publishes no top-down events";
+                    return;
+                }
+
+                for (detail::sysfs_event const& e : events)
+                {
+                    if (!level1.add(e.type, e.config))
+                    {
+                        reason = std::string("perf_event_open: ") + std::strerror(level1.error);
+                        unsupported = reason.c_str();
+                        return;
+                    }
+                }
+
+                // Missing level 2 events are left out.
+                level2.add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+                if (!level2.empty())
+                {
+                    has_mispredicts = level2.add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+                    has_icache = level2.add(PERF_TYPE_HW_CACHE, detail::cache(PERF_COUNT_HW_CACHE_L1I));
+                    has_itlb = level2.add(PERF_TYPE_HW_CACHE, detail::cache(PERF_COUNT_HW_CACHE_ITLB));
+                }
+            }
+
+            template<class Job>
+            breakdown measure(Job&& job)
+            {
+                if (unsupported)
+                    return none(unsupported);
+
+                if (!level2.empty())
+                    level2.start();
+                level1.start();
+                job();
+                std::vector<double> c = level1.stop();
+                std::vector<double> const l2 = level2.empty() ? std::vector<double>() : level2.stop();
+
+                for (std::size_t i = 0; i != c.size(); ++i)
+                    c[i] *= events[i].scale;
+                double const slots = c[0];
+                if (slots <= 0)
+                    return none("no slots were counted");
+
+                breakdown b = none("");
+                if (metrics)
+                {
+                    b.frontend = c[1] / slots;
+                    b.bad_speculation = c[2] / slots;
+                    b.backend = c[3] / slots;
+                    b.retiring = c[4] / slots;
+                }
+                else
+                {
+                    b.frontend = c[1] / slots;
+                    b.bad_speculation = (c[2] - c[3] + c[4]) / slots;
+                    b.retiring = c[3] / slots;
+                    b.backend = 1 - b.frontend - b.bad_speculation - b.retiring;
+                }
+
+                if (!l2.empty() && l2[0] > 0)
+                {
+                    std::size_t i = 1;
+                    double const ki = l2[0] / 1000;
+                    if (has_mispredicts)
+                        b.mispredicts = l2[i++] / ki;
+                    if (has_icache)
+                        b.icache_misses = l2[i++] / ki;
+                    if (has_itlb)
+                        b.itlb_misses = l2[i++] / ki;
+                }
+                return b;
+            }
+
+        private:
+            template<std::size_t N>
+            bool find_all(char const* pmu, char const* const (&names)[N])
+            {
+                events.clear();
+                for (char const* name : names)
+                {
+                    detail::sysfs_event const e = detail::find(pmu, name);
+                    if (!e.found)
+                    {
+                        events.clear();
+                        return false;
+                    }
+                    events.push_back(e);
+                }
+                return true;
+            }
+
+            std::string reason;
+            char const* unsupported;
+            bool metrics;
+            bool has_mispredicts, has_icache, has_itlb;
+            std::vector<detail::sysfs_event> events;
+            detail::group level1, level2;
+        };
+#else
+        class counters
+        {
+        public:
+            template<class Job>
+            breakdown measure(Job&&)
+            {
+                return none("perf_event_open is Linux only");
+            }
+        };
+#endif
+
+        // Breaks down a run of job, with counters opened once for the
+        // whole program.
+        template<class Job>
+        breakdown measure(Job&& job)
+        {
+            static counters c;
+            return c.measure(job);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,257 @@
+#if !defined(WORK_STEALING_POOL_HPP)
+#define WORK_STEALING_POOL_HPP
+
+// A work-stealing scheduler templated on its task type, so that the
+// wrappers under test can be compared as the task a fork-join runtime
+// stores.  Every worker owns a Chase-Lev deque: it pushes and pops at the
+// bottom while idle workers steal from the top of a random victim.
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace concurrent
+{
+    // Bounded Chase-Lev deque holding the tasks themselves rather than
+    // pointers to them.  A task is only moved out once the index it sits
+    // at has been claimed, so each cell also records whether it is still
+    // full: the owner never reuses a cell a thief is still moving out of.
+    template<class T>
+    class ws_deque
+    {
+    public:
+        // capacity must be a power of two.
+        explicit ws_deque(std::size_t capacity)
+          : cells(new cell[capacity]), mask(capacity - 1)
+        {
+            assert(capacity >= 2 && (capacity & mask) == 0);
+            for (std::size_t i = 0; i != capacity; ++i)
+                cells[i].full.store(false, std::memory_order_relaxed);
+            top.store(0, std::memory_order_relaxed);
+            bottom.store(0, std::memory_order_relaxed);
+        }
+
+        ws_deque(ws_deque const&) = delete;
+        ws_deque& operator=(ws_deque const&) = delete;
+
+        ~ws_deque()
+        {
+            T v;
+            while (pop(v))
+                ;
+        }
+
+        // Owner only.  Moves v in unless the deque is full, in which case
+        // v is left untouched.
+        bool push(T&& v)
+        {
+            std::int64_t const b = bottom.load(std::memory_order_relaxed);
+            std::int64_t const t = top.load(std::memory_order_acquire);
+            if (b - t > static_cast<std::int64_t>(mask))
+                return false;
+
+            cell& c = cells[b & mask];
+            while (c.full.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            ::new (&c.storage) T(std::move(v));
+            c.full.store(true, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Owner only.  Takes the task pushed last.
+        bool pop(T& v)
+        {
+            std::int64_t const b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = top.load(std::memory_order_relaxed);
+            if (t > b)
+            {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            if (t == b)
+            {
+                // The last task: race the thieves for it.
+                bool const won = top.compare_exchange_strong(
+                    t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                if (!won)
+                    return false;
+            }
+            take(cells[b & mask], v);
+            return true;
+        }
+
+        // Any thread.  Takes the oldest task.
+        bool steal(T& v)
+        {
+            std::int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t const b = bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return false;
+            if (!top.compare_exchange_strong(
+                    t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return false;
+            take(cells[t & mask], v);
+            return true;
+        }
+
+    private:
+        struct cell
+        {
+            std::atomic<bool> full;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        static void take(cell& c, T& v)
+        {
+            T* p = reinterpret_cast<T*>(&c.storage);
+            v = std::move(*p);
+            p->~T();
+            c.full.store(false, std::memory_order_release);
+        }
+
+        std::unique_ptr<cell[]> const cells;
+        std::size_t const mask;
+        alignas(64) std::atomic<std::int64_t> top;
+        alignas(64) std::atomic<std::int64_t> bottom;
+    };
+
+    // Task is any callable taking no argument that can be default
+    // constructed, moved and constructed from a lambda.  The thread
+    // calling run() takes part as worker 0.
+    template<class Task>
+    class work_stealing_pool
+    {
+    public:
+        explicit work_stealing_pool(std::size_t count, std::size_t capacity = 1024)
+          : stopping(false)
+        {
+            assert(count >= 1);
+            for (std::size_t i = 0; i != count; ++i)
+                workers.emplace_back(new worker(capacity, i));
+            for (std::size_t i = 1; i != count; ++i)
+            {
+                threads.emplace_back([this, i]
+                {
+                    current() = workers[i].get();
+                    while (!stopping.load(std::memory_order_acquire))
+                    {
+                        if (!run_one())
+                            std::this_thread::yield();
+                    }
+                    current() = nullptr;
+                });
+            }
+        }
+
+        work_stealing_pool(work_stealing_pool const&) = delete;
+        work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+        ~work_stealing_pool()
+        {
+            stopping.store(true, std::memory_order_release);
+            for (std::thread& t : threads)
+                t.join();
+        }
+
+        std::size_t size() const
+        {
+            return workers.size();
+        }
+
+        // Runs root on the calling thread, which works for the pool until
+        // root returns.  Root waits for whatever it spawns.
+        template<class Fn>
+        void run(Fn&& root)
+        {
+            assert(!current());
+            current() = workers[0].get();
+            std::forward<Fn>(root)();
+            current() = nullptr;
+        }
+
+        // From a worker only.  Makes t available to the other workers, or
+        // runs it right away if the worker's deque is full.
+        void spawn(Task t)
+        {
+            worker* self = current();
+            assert(self);
+            if (!self->tasks.push(std::move(t)))
+                t();
+        }
+
+        // From a worker only.  Runs tasks, its own first, until done()
+        // holds, so a task waiting for the ones it spawned keeps its
+        // worker busy.
+        template<class Pred>
+        void wait_until(Pred done)
+        {
+            while (!done())
+            {
+                if (!run_one())
+                    std::this_thread::yield();
+            }
+        }
+
+    private:
+        struct worker
+        {
+            worker(std::size_t capacity, std::size_t index)
+              : tasks(capacity), seed(static_cast<std::uint32_t>(index) * 2654435761u + 1)
+            {}
+
+            ws_deque<Task> tasks;
+            std::uint32_t seed;
+        };
+
+        static worker*& current()
+        {
+            static thread_local worker* self = nullptr;
+            return self;
+        }
+
+        // xorshift32, one state per worker.
+        static std::uint32_t next_random(std::uint32_t& x)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return x;
+        }
+
+        // Pops a task of the calling worker's own, or else steals one from
+        // a random victim, and runs it.
+        bool run_one()
+        {
+            worker* self = current();
+            Task t;
+            bool found = self->tasks.pop(t);
+            if (!found && workers.size() > 1)
+            {
+                std::size_t const victim = next_random(self->seed) % workers.size();
+                found = workers[victim].get() != self && workers[victim]->tasks.steal(t);
+            }
+            if (found)
+                t();
+            return found;
+        }
+
+        std::vector<std::unique_ptr<worker> > workers;
+        std::vector<std::thread> threads;
+        std::atomic<bool> stopping;
+    };
+}
+
+#endif
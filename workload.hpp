@@ -0,0 +1,168 @@
+#if !defined(WORKLOAD_HPP)
+#define WORKLOAD_HPP
+
+// Shared by the workload benchmarks: the wrappers under test for any
+// signature, an allocation counter and throughput reporting.  Like
+// measure.hpp this header defines non-inline functions, so it is meant
+// to be included from the one translation unit of each benchmark.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <boost/type_erasure/any.hpp>
+#include <boost/type_erasure/builtin.hpp>
+#include <boost/type_erasure/callable.hpp>
+#include <boost/function.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include "function.h"
+#include "delegate.hpp"
+#include "stdex.hpp"
+#include "function2.hpp"
+#include "fixed_size_function.hpp"
+#include "forwarder.hpp"
+#include "StaticFunction.h"
+#include "Function.h"
+#include "smallfun.hpp"
+
+#ifndef _WIN32
+  #include "cxx_function.hpp"
+#else
+  #include "cxx_function_msvc.hpp"
+#endif
+
+#include "measure.hpp"
+
+
+template<class... Sig>
+using multifunction =
+    boost::type_erasure::any<
+        boost::mpl::vector<
+            boost::type_erasure::copy_constructible<>,
+            boost::type_erasure::typeid_<>,
+            boost::type_erasure::relaxed,
+            boost::type_erasure::callable<Sig>...
+        >
+    >;
+
+// The fixed-capacity wrappers, sized as in various.cpp.
+template<class Sig>
+using gnr_forwarder = gnr::forwarder<Sig, 48>;
+
+template<class Sig>
+using embxx_util_StaticFunction = embxx::util::StaticFunction<Sig, 48>;
+
+template<class Sig>
+using Function_ = Function<Sig, 56>;
+
+template<class Sig>
+using SmallFun = smallfun::SmallFun<Sig, 48>;
+
+namespace test
+{
+    // Number of allocations made so far by the calling thread.
+    inline std::size_t& allocations()
+    {
+        thread_local std::size_t count = 0;
+        return count;
+    }
+
+    // Number of bytes requested from the heap so far by the calling thread.
+    inline std::size_t& allocated_bytes()
+    {
+        thread_local std::size_t count = 0;
+        return count;
+    }
+
+    // Runs job until at least min_time seconds have been spent in it and
+    // returns the average time of one run.  The first run only warms up.
+    template <class Job>
+    double time_per_run(Job&& job, double min_time = 1.0)
+    {
+        job();
+
+        long runs = 0;
+        util::high_resolution_timer time;
+        do
+        {
+            job();
+            ++runs;
+        }
+        while (time.elapsed() < min_time);
+        return time.elapsed() / runs;
+    }
+
+    // The same for a job that times itself, returning the seconds spent
+    // in the part of it that counts.
+    template <class Job>
+    double timed_per_run(Job&& job, double min_time = 1.0)
+    {
+        job();
+
+        long runs = 0;
+        double elapsed = 0;
+        do
+        {
+            elapsed += job();
+            ++runs;
+        }
+        while (elapsed < min_time);
+        return elapsed / runs;
+    }
+
+    void report_name(char const* name)
+    {
+        std::cout.precision(4);
+        std::cout << name << ": ";
+        for (int i = 0; i < (20-int(strlen(name))); ++i)
+            std::cout << ' ';
+    }
+
+    void report_rate(char const* name, double rate, char const* unit)
+    {
+        report_name(name);
+        std::cout << std::fixed << rate / 1e6 << " [M" << unit << "/s] ";
+    }
+}
+
+// GCC pairs malloc/free with the builtin new/delete it inlines them into.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+    ++test::allocations();
+    test::allocated_bytes() += size;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+  #pragma GCC diagnostic pop
+#endif
+
+#define WORKLOAD_RUN(r, data, elem)                                 \
+    elem::run(BOOST_PP_STRINGIZE(elem));                            \
+    /***/
+
+// Runs every case of the sequence, as BOOST_SPIRIT_TEST_BENCHMARK does.
+#define WORKLOAD_BENCHMARK(FSeq)                                    \
+    BOOST_PP_SEQ_FOR_EACH(WORKLOAD_RUN, _, FSeq)                    \
+    /***/
+
+#endif